@@ -0,0 +1,268 @@
+//==============================================================================
+// bench_queue.cpp
+//	Timing driver comparing the 'libchtime' library changing a batch of
+//	files one at a time against changing them on a pool of worker threads.
+//
+// Notes
+//	This program is written for Microsoft Win32 only.
+//
+//	Usage: bench_queue DIR [DEPTH [COUNT]]
+//
+//	Creates 'COUNT' (default 1000) empty files in directory 'DIR', changes
+//	their timestamps once one at a time and once with a queue depth of
+//	'DEPTH' (default 'ChtimeExecutor::QUEUE_DEPTH'), displays the files per
+//	second and the elapsed and process CPU time per file of each pass, and
+//	removes the files again.  Win32 has no asynchronous
+//	form of 'SetFileTime()', so the worker threads only help where each
+//	change waits on the file system, such as on a network share; 'DIR'
+//	should be on the kind of file system being measured.
+//
+// Copyright 2000-2010 by David R. Tribble, all rights reserved.
+//------------------------------------------------------------------------------
+
+
+// Identification
+
+static char		ID[] =
+    "@(#)drt/src/cmd/bench_queue.cpp $Revision: 1.1 $ $Date: 2026/10/18 12:00:00 $\n";
+
+
+// System includes
+
+#ifndef _WIN32
+ #error Compile this under Win32 only
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define WIN32_LEAN_AND_MEAN	1
+#include <windows.h>
+
+
+// Local includes
+
+#include "libchtime.h"
+
+
+// Local constants
+
+#define and		&&
+#define or		||
+#define not		!
+
+#if 0
+ #define STD		std
+#else
+ #define STD		/**/
+#endif
+
+#define BENCH_COUNT	1000		// Default number of files
+#define BENCH_MAX	100000		// Max number of files
+
+
+//------------------------------------------------------------------------------
+// ::cpuTime()
+//	Determine the CPU time used so far by the process.
+//
+// Returns
+//	The kernel and user time of all the threads of the process, in seconds,
+//	or zero if it can't be determined.
+//------------------------------------------------------------------------------
+
+static double cpuTime()
+{
+    FILETIME		created;
+    FILETIME		exited;
+    FILETIME		kernel;
+    FILETIME		user;
+    ULARGE_INTEGER	k;
+    ULARGE_INTEGER	u;
+
+    if (not ::GetProcessTimes(::GetCurrentProcess(), &created, &exited,
+            &kernel, &user))
+        return 0.0;
+
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (double) (LONGLONG) (k.QuadPart + u.QuadPart) / 1.0e7;
+}
+
+
+//------------------------------------------------------------------------------
+// ::timePass()
+//	Change the timestamps of a batch of files, and display the elapsed time
+//	and the CPU time (of all the threads of the process) taken.
+//
+// Param	fnames
+//	The names of the files to change.
+//
+// Param	n
+//	The number of filenames in 'fnames'.
+//
+// Param	depth
+//	The number of worker threads, or 1 to change the files one at a time.
+//
+// Param	secs
+//	The new timestamp of the files, in seconds since 1970-01-01 00:00 UTC.
+//
+// Returns
+//	The elapsed time in seconds, or a negative value if any of the files
+//	could not be changed.
+//------------------------------------------------------------------------------
+
+static double timePass(const char *const *fnames, int n, int depth,
+    ULONGLONG secs)
+{
+    ChtimePlan		plan;
+    ChtimeExecutor	exec(plan);
+    ChtimeResult *	res;
+    LARGE_INTEGER	freq;
+    LARGE_INTEGER	t0;
+    LARGE_INTEGER	t1;
+    double		c0;
+    double		c1;
+    double		elapsed;
+    int			rc;
+
+    // Set up the plan and the executor
+    plan.m_useTime = true;
+    ChtimePlan::toFileTime(secs, 0, &plan.m_time);
+
+    if (depth > 1  and  not exec.setQueueDepth(depth))
+    {
+        STD::fprintf(stderr, "Can't start %d worker threads\n", depth);
+        STD::fflush(stderr);
+        return -1.0;
+    }
+
+    // Change the files
+    res = new ChtimeResult[n];
+    ::QueryPerformanceFrequency(&freq);
+    c0 = cpuTime();
+    ::QueryPerformanceCounter(&t0);
+    rc = exec.changeFiles(fnames, n, res);
+    ::QueryPerformanceCounter(&t1);
+    c1 = cpuTime();
+    delete[] res;
+
+    if (rc != ChtimePlan::RC_OKAY)
+    {
+        STD::fprintf(stderr, "Can't change the files\n");
+        STD::fflush(stderr);
+        return -1.0;
+    }
+
+    // Display the throughput, and the elapsed and CPU times
+    elapsed = (double) (t1.QuadPart - t0.QuadPart) / (double) freq.QuadPart;
+    if (depth > 1)
+        STD::fprintf(stdout, "Queue depth %2d: ", depth);
+    else
+        STD::fprintf(stdout, "Serial:         ");
+    STD::fprintf(stdout, "%d files in %.3f sec, %.0f files/sec, "
+        "%.1f usec/file, %.1f CPU usec/file\n", n, elapsed,
+        (elapsed > 0.0 ? n/elapsed : 0.0), elapsed*1.0e6/n,
+        (c1 - c0)*1.0e6/n);
+    STD::fflush(stdout);
+
+    return elapsed;
+}
+
+
+//------------------------------------------------------------------------------
+// ::main()
+//
+// Returns
+//	Zero on success, otherwise 1.
+//------------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    const char **	fnames =	NULL;
+    char *		names =		NULL;
+    int			depth =		ChtimeExecutor::QUEUE_DEPTH;
+    int			count =		BENCH_COUNT;
+    int			made =		0;
+    int			rc =		1;
+    double		serial;
+    double		queued;
+    char		c;
+    int			i;
+
+    // Parse the command line args
+    if (argc < 2  or  argc > 4)
+        goto usage;
+    if (argc > 2  and  (STD::sscanf(argv[2], "%d%c", &depth, &c) != 1
+            or  depth < 2  or  depth > ChtimeExecutor::QUEUE_MAX))
+        goto usage;
+    if (argc > 3  and  (STD::sscanf(argv[3], "%d%c", &count, &c) != 1
+            or  count < 1  or  count > BENCH_MAX))
+        goto usage;
+    if (STD::strlen(argv[1]) > MAX_PATH-20)
+        goto usage;
+
+    // Create the files
+    names = new char[count*(MAX_PATH+1)];
+    fnames = new const char *[count];
+
+    for (made = 0;  made < count;  made++)
+    {
+        char *	fname;
+        HANDLE	h;
+
+        fname = &names[made*(MAX_PATH+1)];
+        STD::sprintf(fname, "%s\\bench%06d.tmp", argv[1], made);
+        fnames[made] = fname;
+
+        h = ::CreateFile(fname, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0,
+                NULL);
+        if (h == INVALID_HANDLE_VALUE)
+        {
+            STD::fprintf(stderr, "Can't create: %s\n", fname);
+            STD::fflush(stderr);
+            goto done;
+        }
+        ::CloseHandle(h);
+    }
+
+    // Change the files one at a time, then on the worker threads, each pass
+    // to a different time so that every file is modified
+    serial = timePass(fnames, count, 1, 1000000000);
+    queued = timePass(fnames, count, depth, 1000086400);
+    if (serial < 0.0  or  queued < 0.0)
+        goto done;
+
+    if (queued > 0.0)
+    {
+        STD::fprintf(stdout, "Speedup:        %.2fx\n", serial/queued);
+        STD::fflush(stdout);
+    }
+    rc = 0;
+
+done:
+    // Clean up
+    for (i = 0;  i < made;  i++)
+        ::DeleteFile(fnames[i]);
+
+    delete[] fnames;
+    fnames = NULL;
+    delete[] names;
+    names = NULL;
+
+    return rc;
+
+usage:
+    STD::fprintf(stderr, "usage: bench_queue DIR [DEPTH [COUNT]]\n\n");
+    STD::fprintf(stderr,
+        "Times changing COUNT (default %d) new files in DIR one at a time,\n"
+        "then with DEPTH (2 to %d, default %d) worker threads.\n",
+        (int) BENCH_COUNT, (int) ChtimeExecutor::QUEUE_MAX,
+        (int) ChtimeExecutor::QUEUE_DEPTH);
+    STD::fflush(stderr);
+    return 1;
+}
+
+// End bench_queue.cpp
@@ -21,8 +21,8 @@ static char		COPYRIGHT[] =
     "@(#)Copyright 2000-2010 by David R. Tribble, all rights reserved.\n";
 
 #define ID_PROG		"chtime"
-#define ID_VERS		"1.5"
-#define ID_DATE		"2010-03-12"
+#define ID_VERS		"2.0"
+#define ID_DATE		"2026-10-18"
 
 #ifdef DEBUGS
  #undef  DEBUGS
@@ -50,7 +50,7 @@ static char		COPYRIGHT[] =
 
 // Local includes
 
-// (None)
+#include "libchtime.h"
 
 
 // Local constants
@@ -69,41 +69,195 @@ static char		COPYRIGHT[] =
 //------------------------------------------------------------------------------
 // class Program
 //	Embodies the execution of this entire program.
+//
+//	The options are parsed into a plan, which is applied by an executor, and
+//	the outcome for each file is displayed as it is reported back.
 //------------------------------------------------------------------------------
 
-#define Program_VS	105			// Class version, 1.5
+#define Program_VS	280			// Class version, 2.8
 
-class Program
+class Program: public ChtimeReporter
 {
 public: // Shared constants
     enum ExitCodes				// Program exit codes
     {
-        RC_OKAY =	0,	// Success
-        RC_READ =	1,	// Can't open/read a file
-        RC_WRITE =	2,	// Can't open/write a file
-        RC_TIME =	3,	// Can't get timestamp of a file
-        RC_FIND =	4,	// Can't find wildcarded filename
-        RC_CREATE =	5,	// Can't create a new file
-        RC_USAGE =	127	// Improper command usage
+        RC_OKAY =	ChtimePlan::RC_OKAY,	// Success
+        RC_READ =	ChtimePlan::RC_READ,	// Can't open/read a file
+        RC_WRITE =	ChtimePlan::RC_WRITE,	// Can't open/write a file
+        RC_TIME =	ChtimePlan::RC_TIME,	// Can't get timestamp
+        RC_FIND =	ChtimePlan::RC_FIND,	// Can't find wildcarded name
+        RC_CREATE =	ChtimePlan::RC_CREATE,	// Can't create a new file
+        RC_USAGE =	127			// Improper command usage
+    };
+
+    enum Limits					// Implementation limits
+    {
+        CKPT_INTERVAL =	5000,	// Checkpoint interval (msec)
+        CKPT_NAME_MAX =	32*1024,	// Max checkpointed filename length
+        WATCH_SETTLE =	250,	// Watch quiet time before changes (msec)
+        WATCH_DELAY =	2000,	// Watch maximum change delay (msec)
+        WATCH_BATCH =	1024,	// Watch maximum batched filenames
+        WATCH_RETRIES =	20,	// Watch maximum retries of open files
+        WATCH_BUFSIZE =	64*1024,	// Watch notification buffer size
+        SERVE_THREADS =	8,	// Server worker threads
+        SERVE_BUFSIZE =	64*1024,	// Server pipe buffer size
+        SERVE_TIMEOUT =	5000,	// Client wait for a server (msec)
+        SERVE_MAGIC =	0x31544843,	// Server message identifier, "CHT1"
+        SERVE_NAMES_MAX = 8192,	// Max filenames per request
+        SERVE_MSG_MAX =	4*1024*1024,	// Max message size
+        HIST_INIT =	256	// Initial histogram hash table size
     };
 
 private: // Shared constants
     static const char *const
 			s_usage[];		// Usage messages
 
+    enum LongOptIds				// Long option identifiers
+    {
+        LO_CHECKPOINT,		// --checkpoint FILE
+        LO_RESUME,		// --resume FILE
+        LO_SHARD,		// --shard I/N
+        LO_CLAMP,		// --clamp[=TIME]
+        LO_WATCH,		// --watch
+        LO_TAR,			// --tar
+        LO_SERVE,		// --serve PIPE
+        LO_CLIENT,		// --client PIPE
+        LO_LIST,		// --list
+        LO_HISTOGRAM,		// --histogram BUCKET
+        LO_OLDER,		// --older TIME
+        LO_NEWER,		// --newer TIME
+        LO_SIZE,		// --size [MIN]-[MAX]
+        LO_TYPE,		// --type f|d
+        LO_EXCLUDE,		// --exclude PATTERN
+        LO_DIRCACHE,		// --dir-cache[=N]
+        LO_PRESERVE,		// --preserve-dir-times
+        LO_QUEUE		// --queue-depth[=N]
+    };
+
+    enum HistBuckets				// Histogram bucket sizes
+    {
+        HB_NONE,		// No histogram
+        HB_YEAR,		// Years
+        HB_MONTH,		// Months
+        HB_DAY,			// Days
+        HB_HOUR			// Hours
+    };
+
+    struct HistBucket				// Histogram bucket
+    {
+        unsigned long	key;		// Bucket time, as 'YYYYMMDDhh'
+        unsigned long	count;		// Number of files
+    };
+
+    enum LongOptArgs				// Long option argument kinds
+    {
+        LA_NONE,		// Takes no argument
+        LA_REQUIRED,		// Requires an argument
+        LA_OPTIONAL		// Takes an optional '=value' argument
+    };
+
+    struct LongOpt				// Long option descriptor
+    {
+        const char *	name;		// Option name, without '--'
+        int		arg;		// Option argument kind, 'LA_XXX'
+        int		id;		// Option identifier, 'LO_XXX'
+    };
+
+    static const LongOpt
+			s_longOpts[];		// Long options
+
+    struct ServeRequest				// Server request header
+    {
+        DWORD		magic;		// Message identifier, 'SERVE_MAGIC'
+        DWORD		count;		// Number of filenames that follow
+        BYTE		create;		// Plan settings
+        BYTE		localTime;
+        BYTE		readBack;
+        BYTE		useTime;
+        BYTE		clamp;
+        LONG		year;
+        LONG		mon;
+        LONG		mday;
+        LONG		hour;
+        LONG		min;
+        LONG		sec;
+        LONG		msec;
+        FILETIME	time;
+        FILETIME	clampTime;
+        DWORD		shardIdx;
+        DWORD		shardCnt;
+    };
+
+    struct ServeReply				// Server reply header
+    {
+        DWORD		magic;		// Message identifier, 'SERVE_MAGIC'
+        DWORD		count;		// Number of results that follow
+    };
+
+    struct ServeResult				// Server reply, for one file
+    {
+        LONG		rc;		// Status, 'RC_XXX'
+        BYTE		skipped;	// File is not selected by the plan
+        BYTE		changed;	// Timestamp was modified
+        FILETIME	mtime;		// New timestamp (UTC)
+        char		msg[40];	// Failure message
+    };
+
+    struct Watch				// Watched directory
+    {
+        HANDLE		dir;		// Directory handle
+        OVERLAPPED	ov;		// Pending notification request
+        char		path[MAX_PATH+1]; // Directory path prefix
+        const char *	pat;		// Filename pattern
+        DWORD		buf[WATCH_BUFSIZE/sizeof(DWORD)];
+					// Notification buffer
+    };
+
 private: // Variables
+    ChtimePlan		m_plan;			// Timestamp changes to make
+    ChtimeExecutor *	m_exec;			// Timestamp changer
     bool		m_opt_verbose;		// Display verbose output
-    bool		m_opt_create;		// Create nonexistent files
-    bool		m_opt_localTime;	// Use local time, not UTC
-    int			m_opt_year;		// Changed year number
-    int			m_opt_mon;		// Changed month number
-    int			m_opt_mday;		// Changed day of the month
-    int			m_opt_hour;		// Changed hour number
-    int			m_opt_min;		// Changed minute number
-    int			m_opt_sec;		// Changed second number
-    int			m_opt_msec;		// Changed millisecond number
     const char *	m_opt_fname;		// Model file name
-    FILETIME		m_opt_fname_tm;		// Model file timestamp
+    const char *	m_opt_ckptName;		// Checkpoint file name
+    const char *	m_opt_resumeName;	// Resume checkpoint file name
+    bool		m_opt_clamp;		// Clamp newer timestamps
+    const char *	m_opt_clampSpec;	// Clamp time specification
+
+    int			m_ckpt_arg;		// Cursor, current filename arg
+    long		m_ckpt_match;		// Cursor, completed matches
+    char *		m_ckpt_name;		// Cursor, last completed match
+    unsigned long	m_ckpt_hash;		// Hash of the filename args
+    DWORD		m_ckpt_tick;		// Time of last checkpoint
+    char *		m_ckpt_buf;		// Checkpoint contents
+    char *		m_ckpt_tmp;		// Temporary checkpoint file name
+    int			m_resume_arg;		// Resume cursor, filename arg
+    long		m_resume_match;		// Resume cursor, matches
+    char *		m_resume_name;		// Resume cursor, last match
+    bool		m_opt_watch;		// Watch for new files
+    bool		m_watching;		// Watching for new files
+    char *		m_watch_names;		// Batched changed filenames
+    int			m_watch_cnt;		// Number of batched filenames
+    int *		m_watch_tries;		// Retries of batched filenames
+    bool		m_opt_tar;		// Change tar archive members
+    const char *	m_opt_serveName;	// Server pipe name
+    const char *	m_opt_clientName;	// Client pipe name
+    char		m_pipeName[MAX_PATH+1];	// Full pipe name
+    HANDLE volatile	m_servePipe;		// First server pipe instance
+    bool		m_opt_list;		// List file timestamps
+    int			m_opt_histBucket;	// Histogram bucket, 'HB_XXX'
+    HistBucket *	m_hist;			// Histogram buckets, hashed by key
+    int			m_histCnt;		// Number of histogram buckets
+    int			m_histSize;		// Size of 'm_hist', a power of 2
+    const char *	m_opt_olderSpec;	// Older-than time specification
+    const char *	m_opt_newerSpec;	// Newer-than time specification
+    int			m_opt_dirCache;		// Cached directories, or 0
+    bool		m_opt_preserveDirs;	// Keep directory timestamps
+    int			m_opt_queueDepth;	// Worker threads, or 0
+    ChtimeDirTimes *	m_times;		// Directory times to keep, or null
+
+private: // Static variables
+    static ChtimeDirTimes *volatile
+			s_dirTimes;		// Times to restore on interrupt
 
 public: // Functions
     /*void*/		~Program();		// Destructor
@@ -111,11 +265,21 @@ public: // Functions
 
     int			main(int agrc, const char *const *argv);
 						// Execute this program
+    int			report(const ChtimeResult *res);
+						// Display the outcome for a file
+    void		progress(const char *fname, long match);
+						// Record the search progress
 
 private: // Static functions
     static void		usage();		// Print usage msg and punt
-    static bool		parseDate(const char *date, SYSTEMTIME *st);
-						// Parse a date specification
+    static DWORD WINAPI	serveThread(LPVOID arg);
+						// Server worker thread
+    static BOOL WINAPI	ctrlHandler(DWORD type);
+						// Console interrupt handler
+    static unsigned long hashArgs(int argc, const char *const *argv);
+						// Hash the filename args
+    static bool		readMessage(HANDLE pipe, char **buf, DWORD *size,
+			    DWORD *len);	// Read a pipe message
 
 private: // Functions
     // Constructors and destructors not provided
@@ -126,10 +290,37 @@ private: // Functions
 
     int			parseOpts(int argc, const char *const *argv);
 						// Parse command line options
-    int			changeFiles(const char *fname);
-						// Change times of some files
+    int			parseLongOpt(int argc, const char *const *argv,
+			    int optind);	// Parse a long option
+    int			readCheckpoint(int argc, const char *const *argv);
+						// Read a resume checkpoint
+    int			writeCheckpoint(bool force);
+						// Write a checkpoint
+    int			showTime(const char *fname, const FILETIME *mtime) const;
+						// Display a new timestamp
+    int			showResult(const ChtimeResult *res) const;
+						// Display the outcome for a file
     int			changeFile(const char *fname);
 						// Change time of a filename
+    int			watchFiles(int argc, const char *const *argv);
+						// Watch for changed files
+    int			addWatchName(const char *fname, bool add);
+						// Batch a changed filename
+    int			flushWatchNames(bool retry);
+						// Change batched filenames
+    int			serve();		// Serve client requests
+    void		serveClients();		// Serve clients, in a thread
+    HANDLE		createPipe(bool first);	// Create a server pipe instance
+    int			requestFiles(int argc, const char *const *argv);
+						// Request changes from a server
+    int			countFile(const ChtimeResult *res);
+						// Count a file in the histogram
+    int			restoreDirTimes();	// Restore directory timestamps
+    void		showHistogram();	// Display the histogram
+    static int		compareBuckets(const void *a, const void *b);
+						// Compare histogram buckets
+    static int		hashBucket(unsigned long key, int size);
+						// Hash a histogram key
 };
 
 
@@ -139,25 +330,50 @@ private: // Functions
 //------------------------------------------------------------------------------
 
 /*void*/ Program::Program():
+    m_plan(),
+    m_exec(NULL),
     m_opt_verbose(true),
-    m_opt_create(false),
-    m_opt_localTime(true),
-    m_opt_year(-1),
-    m_opt_mon(-1),
-    m_opt_mday(-1),
-    m_opt_hour(-1),
-    m_opt_min(-1),
-    m_opt_sec(-1),
-    m_opt_msec(-1),
     m_opt_fname(NULL),
-    m_opt_fname_tm()
+    m_opt_ckptName(NULL),
+    m_opt_resumeName(NULL),
+    m_opt_clamp(false),
+    m_opt_clampSpec(NULL),
+    m_ckpt_arg(0),
+    m_ckpt_match(0),
+    m_ckpt_name(NULL),
+    m_ckpt_hash(0),
+    m_ckpt_tick(0),
+    m_ckpt_buf(NULL),
+    m_ckpt_tmp(NULL),
+    m_resume_arg(0),
+    m_resume_match(0),
+    m_resume_name(NULL),
+    m_opt_watch(false),
+    m_watching(false),
+    m_watch_names(NULL),
+    m_watch_cnt(0),
+    m_watch_tries(NULL),
+    m_opt_tar(false),
+    m_opt_serveName(NULL),
+    m_opt_clientName(NULL),
+    m_servePipe(NULL),
+    m_opt_list(false),
+    m_opt_histBucket(HB_NONE),
+    m_hist(NULL),
+    m_histCnt(0),
+    m_histSize(0),
+    m_opt_olderSpec(NULL),
+    m_opt_newerSpec(NULL),
+    m_opt_dirCache(0),
+    m_opt_preserveDirs(false),
+    m_opt_queueDepth(0),
+    m_times(NULL)
 {
-#if Program_VS != 105
+#if Program_VS != 280
  #error Class Program has changed
 #endif
 
-    // Initialize
-    ::GetSystemTimeAsFileTime(&m_opt_fname_tm);
+    // Nothing else to do
 }
 
 
@@ -168,11 +384,25 @@ private: // Functions
 
 /*void*/ Program::~Program()
 {
-#if Program_VS != 105
+#if Program_VS != 280
  #error Class Program has changed
 #endif
 
-    // Nothing to do
+    // Clean up
+    delete[] m_ckpt_name;
+    m_ckpt_name = NULL;
+    delete[] m_ckpt_buf;
+    m_ckpt_buf = NULL;
+    delete[] m_ckpt_tmp;
+    m_ckpt_tmp = NULL;
+    delete[] m_resume_name;
+    m_resume_name = NULL;
+    delete[] m_watch_names;
+    m_watch_names = NULL;
+    delete[] m_watch_tries;
+    m_watch_tries = NULL;
+    delete[] m_hist;
+    m_hist = NULL;
 }
 
 
@@ -232,149 +462,102 @@ const char *const	Program::s_usage[] =
         "Verbose output (default).",
     "    -y [CC]YY       "
         "Change the year to 'CCYY'.",
+    "    --checkpoint FILE",
+    "                    "
+        "Periodically record the progress of this run in 'FILE'.",
+    "    --resume FILE   "
+        "Skip the work already recorded as done in checkpoint 'FILE'.",
+    "    --shard I/N     "
+        "Change only the files of shard 'I' (0 to N-1) of 'N' shards.",
+    "    --clamp[=TIME]  "
+        "Change only the timestamps later than 'TIME' to 'TIME', which is",
+    "                    "
+        "of the '-t' format or is '@SECS' (seconds since 1970-01-01 UTC).",
+    "                    "
+        "The default is the 'SOURCE_DATE_EPOCH' environment variable.",
+    "    --tar           "
+        "Change the timestamps of the members within the tar archive files,",
+    "                    "
+        "instead of the timestamps of the files themselves.",
+    "    --watch         "
+        "After changing the files, continue to change the files matching",
+    "                    "
+        "the filenames as they are created or written.",
+    "    --serve PIPE    "
+        "Serve requests from '--client' commands on named pipe 'PIPE'.",
+    "    --client PIPE   "
+        "Request the changes from the '--serve' command on named pipe 'PIPE'.",
+    "    --list          "
+        "List the timestamps of the files, instead of changing them.",
+    "    --histogram BUCKET",
+    "                    "
+        "Count the files by timestamp, instead of changing them, in buckets",
+    "                    "
+        "of 'year', 'month', 'day', or 'hour'.",
+    "    --older TIME    "
+        "Change only the files last modified before 'TIME'.",
+    "    --newer TIME    "
+        "Change only the files last modified after 'TIME'.",
+    "    --size [MIN]-[MAX]",
+    "                    "
+        "Change only the files of 'MIN' to 'MAX' bytes, with an optional",
+    "                    "
+        "'K', 'M', 'G', or 'T' suffix; a single size selects that size.",
+    "    --type f|d      "
+        "Change only the files ('f') or only the directories ('d').",
+    "    --exclude PATTERN",
+    "                    "
+        "Do not change the files with names matching 'PATTERN'.",
+    "    --dir-cache[=N] "
+        "Open the files relative to the last 'N' directories used (default",
+    "                    "
+        "64), instead of by their full pathnames.",
+    "    --preserve-dir-times",
+    "                    "
+        "With '-c', keep the timestamps of the directories in which files",
+    "                    "
+        "are created.",
+    "    --queue-depth[=N]",
+    "                    "
+        "Change up to 'N' files at a time, using worker threads (default",
+    "                    "
+        "4).",
     "",
     "If no date or '-f' option is specified, the current date and time will be "
         "used.",
     "",
     "The '-f' option cannot be specified if the '-t', '-y', '-m', or '-d' "
         "options",
-    "are also specified.",
+    "are also specified.  The '--clamp' option cannot be specified with any "
+        "of them.",
     "",
     "Filenames may contain wildcard characters ('?' and '*').",
     NULL
 };
 
-
-//------------------------------------------------------------------------------
-// Program::parseDate()
-//	Parse a date/time specification.
-//
-// Param	date
-//	A date/time specification of the form:
-//	    "[CC]YY-MM-DD[.hh:mm[:ss[.uuu]]]"
-//
-// Param	st
-//	Pointer to a system time structure, which is filled in with the parsed
-//	values of string 'date'.
-//
-// Returns
-//	True if the date/time specification 'date' is correctly formed,
-//	otherwise false.
-//------------------------------------------------------------------------------
-
 /*static*/
-bool Program::parseDate(const char *date, SYSTEMTIME *st)
+const Program::LongOpt	Program::s_longOpts[] =
 {
-    const char *	s;
-    char		buf[10+1];
-    int			v;
-    int			i;
-    bool		done =	false;
-
-    // Initialize
-    STD::memset(st, 0, sizeof(*st));
-
-    // Extract the '[CC]YY' (year) portion
-    s = date;
-    for (i = 0;  STD::isdigit(*s)  and  i < 8;  s++)
-        buf[i++] = *s;
-    if (*s == '\0'  or  i < 2  or  i > 4)
-        return false;
-    buf[i] = '\0';
-    v = STD::atoi(buf);
-    if (v < 100)
-        v += 2000;
-    if (v < 1900  or  v > 2100)
-        return false;
-    st->wYear = v;
-
-    // Extract the 'MM' (month) portion
-    s++;
-    for (i = 0;  STD::isdigit(*s)  and  i < 8;  s++)
-        buf[i++] = *s;
-    if (*s == '\0'  or  i < 1  or  i > 2)
-        return false;
-    buf[i] = '\0';
-    v = STD::atoi(buf);
-    if (v < 1  or  v > 12)
-        return false;
-    st->wMonth = v;
-
-    // Extract the 'DD' (day) portion
-    s++;
-    for (i = 0;  STD::isdigit(*s)  and  i < 8;  s++)
-        buf[i++] = *s;
-    if (i < 1  or  i > 2)
-        return false;
-    buf[i] = '\0';
-    v = STD::atoi(buf);
-    if (v < 1  or  v > 31)
-        return false;
-    st->wDay = v;
-
-    if (*s == '\0')
-        return true;
-
-    // Extract the 'hh' (hour) portion
-    s++;
-    for (i = 0;  STD::isdigit(*s)  and  i < 8;  s++)
-        buf[i++] = *s;
-    if (*s == '\0'  or  i < 1  or  i > 2)
-        return false;
-    buf[i] = '\0';
-    v = STD::atoi(buf);
-    if (v < 0  or  v > 23)
-        return false;
-    st->wHour = v;
-
-    // Extract the 'mm' (minute) portion
-    s++;
-    for (i = 0;  STD::isdigit(*s)  and  i < 8;  s++)
-        buf[i++] = *s;
-    if (i < 1  or  i > 2)
-        return false;
-    buf[i] = '\0';
-    v = STD::atoi(buf);
-    if (v < 0  or  v > 59)
-        return false;
-    st->wMinute = v;
-
-    if (*s == '\0')
-        return true;
-
-    // Extract the 'ss' (second) portion
-    s++;
-    for (i = 0;  STD::isdigit(*s)  and  i < 8;  s++)
-        buf[i++] = *s;
-    if (i < 1  or  i > 2)
-        return false;
-    buf[i] = '\0';
-    v = STD::atoi(buf);
-    if (v < 0  or  v > 59)
-        return false;
-    st->wSecond = v;
-
-    if (*s == '\0')
-        return true;
-
-    // Extract the 'uuu' (millisecond) portion
-    s++;
-    for (i = 0;  STD::isdigit(*s)  and  i < 8;  s++)
-        buf[i++] = *s;
-    if (i < 1  or  i > 3)
-        return false;
-    buf[i] = '\0';
-    v = STD::atoi(buf);
-    if (v < 0  or  v > 999)
-        return false;
-    st->wMilliseconds = v;
-
-    if (*s != '\0')
-        return false;
-
-    // Success
-    return true;
-}
+    { "checkpoint",	LA_REQUIRED,	LO_CHECKPOINT },
+    { "resume",		LA_REQUIRED,	LO_RESUME },
+    { "shard",		LA_REQUIRED,	LO_SHARD },
+    { "clamp",		LA_OPTIONAL,	LO_CLAMP },
+    { "watch",		LA_NONE,	LO_WATCH },
+    { "tar",		LA_NONE,	LO_TAR },
+    { "serve",		LA_REQUIRED,	LO_SERVE },
+    { "client",		LA_REQUIRED,	LO_CLIENT },
+    { "list",		LA_NONE,	LO_LIST },
+    { "histogram",	LA_REQUIRED,	LO_HISTOGRAM },
+    { "older",		LA_REQUIRED,	LO_OLDER },
+    { "newer",		LA_REQUIRED,	LO_NEWER },
+    { "size",		LA_REQUIRED,	LO_SIZE },
+    { "type",		LA_REQUIRED,	LO_TYPE },
+    { "exclude",	LA_REQUIRED,	LO_EXCLUDE },
+    { "dir-cache",	LA_OPTIONAL,	LO_DIRCACHE },
+    { "preserve-dir-times", LA_NONE,	LO_PRESERVE },
+    { "queue-depth",	LA_OPTIONAL,	LO_QUEUE },
+    { NULL,		LA_NONE,	0 }
+};
 
 
 //------------------------------------------------------------------------------
@@ -407,10 +590,21 @@ int Program::parseOpts(int argc, const char *const *argv)
         if (opt[0] == '\0')
             return optind;
 
+        if (opt[0] == '-')
+        {
+            // Parse a long '--name' option, or '--' ending the options
+            if (opt[1] == '\0')
+                return optind+1;
+
+            optind += parseLongOpt(argc, argv, optind);
+            continue;
+        }
+
         while (opt[0] != '\0')
         {
             int		optch;
             SYSTEMTIME	st;
+            char	c;
 
             // Parse the next command line option
             optch = opt[0];
@@ -426,19 +620,27 @@ int Program::parseOpts(int argc, const char *const *argv)
             {
             case 'c':
                 // Create files if they do not already exist
-                m_opt_create = true;
+                m_plan.m_create = true;
                 break;
 
             case 'd':
                 // Change the day of the month of the timestamp
                 if (m_opt_fname != NULL)
                     usage();
-                m_opt_mday = STD::atoi(optarg);
+                if (STD::sscanf(optarg, "%d%c", &m_plan.m_mday, &c) != 1
+                    or  m_plan.m_mday < 1  or  m_plan.m_mday > 31)
+                {
+                    STD::fprintf(stderr, "Bad day of the month: %s\n",
+                        optarg);
+                    STD::fflush(stderr);
+                    usage();
+                }
                 goto next_arg;
 
             case 'f':
                 // Use the modification time from a specified filename
-                if (m_opt_year != -1  or  m_opt_mon != -1  or  m_opt_mday != -1)
+                if (m_plan.m_year != -1  or  m_plan.m_mon != -1
+                    or  m_plan.m_mday != -1)
                     usage();
                 m_opt_fname = optarg;
                 goto next_arg;
@@ -447,7 +649,13 @@ int Program::parseOpts(int argc, const char *const *argv)
                 // Change the month of the timestamp
                 if (m_opt_fname != NULL)
                     usage();
-                m_opt_mon = STD::atoi(optarg);
+                if (STD::sscanf(optarg, "%d%c", &m_plan.m_mon, &c) != 1
+                    or  m_plan.m_mon < 1  or  m_plan.m_mon > 12)
+                {
+                    STD::fprintf(stderr, "Bad month: %s\n", optarg);
+                    STD::fflush(stderr);
+                    usage();
+                }
                 goto next_arg;
 
             case 's':
@@ -459,7 +667,7 @@ int Program::parseOpts(int argc, const char *const *argv)
                 // Use a specific date/time
                 if (m_opt_fname != NULL)
                     usage();
-                if (not parseDate(optarg, &st))
+                if (not ChtimePlan::parseDate(optarg, &st))
                 {
                     STD::fprintf(stderr, "Bad date specification: %s\n",
                         optarg);
@@ -467,18 +675,18 @@ int Program::parseOpts(int argc, const char *const *argv)
                     usage();
                 }
 
-                m_opt_year = st.wYear;
-                m_opt_mon =  st.wMonth;
-                m_opt_mday = st.wDay;
-                m_opt_hour = st.wHour;
-                m_opt_min =  st.wMinute;
-                m_opt_sec =  st.wSecond;
-                m_opt_msec = st.wMilliseconds;
+                m_plan.m_year = st.wYear;
+                m_plan.m_mon =  st.wMonth;
+                m_plan.m_mday = st.wDay;
+                m_plan.m_hour = st.wHour;
+                m_plan.m_min =  st.wMinute;
+                m_plan.m_sec =  st.wSecond;
+                m_plan.m_msec = st.wMilliseconds;
                 goto next_arg;
 
             case 'u':
                 // Use UTC, not local timezone
-                m_opt_localTime = false;
+                m_plan.m_localTime = false;
                 break;
 
             case 'v':
@@ -490,9 +698,17 @@ int Program::parseOpts(int argc, const char *const *argv)
                 // Change the year of the timestamp
                 if (m_opt_fname != NULL)
                     usage();
-                m_opt_year = STD::atoi(optarg);
-                if (m_opt_year < 100)
-                    m_opt_year += 2000;
+                if (STD::sscanf(optarg, "%d%c", &m_plan.m_year, &c) != 1)
+                    m_plan.m_year = -1;
+                if (m_plan.m_year >= 0  and  m_plan.m_year < 100)
+                    m_plan.m_year += 2000;
+
+                if (m_plan.m_year < 1900  or  m_plan.m_year > 2100)
+                {
+                    STD::fprintf(stderr, "Bad year: %s\n", optarg);
+                    STD::fflush(stderr);
+                    usage();
+                }
                 goto next_arg;
 
             case 'h':
@@ -529,413 +745,1981 @@ int Program::parseOpts(int argc, const char *const *argv)
 
 
 //------------------------------------------------------------------------------
-// Program::changeFile()
-//	Change the timestamp of a filename.
+// Program::parseLongOpt()
+//	Parse a long command line option, of the form '--name', '--name=value',
+//	or '--name value'.
 //
-// Param	fname
-//	The name of a file to change.
+// Param	argc
+//	The size of array 'argv'.
+//
+// Param	argv
+//	The command line argument strings.
+//
+// Param	optind
+//	Index of the command line arg within 'argv' containing the option.
 //
 // Returns
-//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
-//	status codes on failure.
+//	The number of command line args parsed (one or two).
 //------------------------------------------------------------------------------
 
-int Program::changeFile(const char *fname)
+int Program::parseLongOpt(int argc, const char *const *argv, int optind)
 {
-    int		err;
-    HANDLE	h;
-    FILETIME	mtime;
-    SYSTEMTIME	mt;
-
-    // Open the (existing) file
-    h = ::CreateFile(
-            (LPCSTR) fname,
-            (DWORD) GENERIC_WRITE,	// Write required to change a timestamp
-            (DWORD) FILE_SHARE_READ,
-            (LPSECURITY_ATTRIBUTES) NULL,
-            (DWORD) OPEN_EXISTING,
-            (DWORD) 0,
-            (HANDLE) NULL);
+    const char *	name;
+    const char *	optarg;
+    const LongOpt *	lo;
+    int			len;
+    int			n;
+
+    // Split the option into its name and '=value' parts
+    name = &argv[optind][2];
+    optarg = STD::strchr(name, '=');
+    if (optarg != NULL)
+        len = optarg++ - name;
+    else
+        len = STD::strlen(name);
 
-    if (h == INVALID_HANDLE_VALUE)
+    // Look up the option name
+    for (lo = &s_longOpts[0];  lo->name != NULL;  lo++)
     {
-        STD::fprintf(stderr, "Can't write: %s\n", fname);
-        STD::fflush(stderr);
-        h = (HANDLE) NULL;
-        err = RC_WRITE;
-        goto fail;
+        if (STD::strncmp(lo->name, name, len) == 0  and  lo->name[len] == '\0')
+            break;
     }
 
-    // Retrieve the file's timestamp
-    if (not ::GetFileTime(h, (FILETIME *) NULL, (FILETIME *) NULL, &mtime))
+    if (lo->name == NULL)
     {
-        STD::fprintf(stderr, "Can't get timestamp for: %s\n", fname);
+        // Unknown command line option
+        STD::fprintf(stderr, "Unknown option '%s'\n", argv[optind]);
         STD::fflush(stderr);
-        err = RC_TIME;
-        goto fail;
+        usage();
     }
 
-#if DEBUGS
-    ::FileTimeToSystemTime(&mtime, &mt);
-    STD::printf("$ stamp: %04d-%02d-%02d %02d:%02d:%02d.%03d Z\n",
-        mt.wYear, mt.wMonth, mt.wDay,
-        mt.wHour, mt.wMinute, mt.wSecond, mt.wMilliseconds);
-#endif
+    // Locate the option argument
+    n = 1;
+    if (lo->arg == LA_REQUIRED  and  optarg == NULL)
+    {
+        if (optind+1 >= argc)
+            usage();
+        optarg = argv[optind+1];
+        n = 2;
+    }
+    else if (lo->arg == LA_NONE  and  optarg != NULL)
+        usage();
 
-    // Convert the timestamp into a broken-down form
-    if (m_opt_localTime)
+    switch (lo->id)
     {
-        if (not ::FileTimeToLocalFileTime(&mtime, &mtime))
+    case LO_CHECKPOINT:
+        // Periodically record the progress of this run
+        m_opt_ckptName = optarg;
+        break;
+
+    case LO_RESUME:
+        // Resume a previous run from its checkpoint
+        m_opt_resumeName = optarg;
+        break;
+
+    case LO_SERVE:
+        // Serve requests from clients
+        m_opt_serveName = optarg;
+        break;
+
+    case LO_LIST:
+        // List the timestamps of the files, without changing them
+        m_opt_list = true;
+        break;
+
+    case LO_HISTOGRAM:
+        // Count the timestamps of the files, without changing them
+        if (STD::strcmp(optarg, "year") == 0)
+            m_opt_histBucket = HB_YEAR;
+        else if (STD::strcmp(optarg, "month") == 0)
+            m_opt_histBucket = HB_MONTH;
+        else if (STD::strcmp(optarg, "day") == 0)
+            m_opt_histBucket = HB_DAY;
+        else if (STD::strcmp(optarg, "hour") == 0)
+            m_opt_histBucket = HB_HOUR;
+        else
         {
-            STD::fprintf(stderr, "Can't get local timestamp for: %s\n",
-                fname);
+            STD::fprintf(stderr, "Bad histogram bucket: %s\n", optarg);
             STD::fflush(stderr);
-            err = RC_TIME;
-            goto fail;
+            usage();
         }
-    }
+        break;
 
-    if (not ::FileTimeToSystemTime(&mtime, &mt))
-    {
-        STD::fprintf(stderr, "Can't convert timestamp for: %s\n", fname);
-        STD::fflush(stderr);
-        err = RC_TIME;
-        goto fail;
-    }
+    case LO_OLDER:
+        // Change only the files older than a given time
+        m_opt_olderSpec = optarg;
+        break;
 
-#if DEBUGS
-    STD::printf("$ stamp: %04d-%02d-%02d %02d:%02d:%02d.%03d LOC\n",
-        mt.wYear, mt.wMonth, mt.wDay,
-        mt.wHour, mt.wMinute, mt.wSecond, mt.wMilliseconds);
-#endif
+    case LO_NEWER:
+        // Change only the files newer than a given time
+        m_opt_newerSpec = optarg;
+        break;
 
-    // Set the file's timestamp
-    if (m_opt_fname != NULL)
-    {
-        // Set the file's timestamp to the model file's modification time
-        mtime = m_opt_fname_tm;
-    }
-    else
-    {
-        // Change the file's timestamp
-        if (m_opt_year != -1)
-            mt.wYear = m_opt_year;
-        if (m_opt_mon != -1)
-            mt.wMonth = m_opt_mon;
-        if (m_opt_mday != -1)
-            mt.wDay = m_opt_mday;
-        if (m_opt_hour != -1)
-            mt.wHour = m_opt_hour;
-        if (m_opt_min != -1)
-            mt.wMinute = m_opt_min;
-        if (m_opt_sec != -1)
-            mt.wSecond = m_opt_sec;
-        if (m_opt_msec != -1)
-            mt.wMilliseconds = m_opt_msec;
-
-#if DEBUGS
-        STD::printf("$ stamp: %04d-%02d-%02d %02d:%02d:%02d.%03d NEW\n",
-            mt.wYear, mt.wMonth, mt.wDay,
-            mt.wHour, mt.wMinute, mt.wSecond, mt.wMilliseconds);
-#endif
+    case LO_SIZE:
+        // Change only the files within a size range
+        {
+            char		buf[40+1];
+            char *		dash;
+            ULONGLONG		min =	0;
+            ULONGLONG		max =	~(ULONGLONG) 0;
+
+            if (STD::strlen(optarg) >= sizeof(buf))
+                goto bad_size;
+            STD::strcpy(buf, optarg);
+            dash = STD::strchr(buf, '-');
+            if (dash == NULL)
+            {
+                // Select a single size
+                if (not ChtimePlan::parseSize(buf, &min))
+                    goto bad_size;
+                max = min;
+            }
+            else
+            {
+                // Select a range of sizes
+                *dash++ = '\0';
+                if (buf[0] != '\0'  and  not ChtimePlan::parseSize(buf, &min))
+                    goto bad_size;
+                if (*dash != '\0'  and  not ChtimePlan::parseSize(dash, &max))
+                    goto bad_size;
+                if (min > max)
+                    goto bad_size;
+            }
+
+            m_plan.setSize(min, max);
+            break;
 
-        // Convert the broken-down timestamp into a filestamp
-        if (not ::SystemTimeToFileTime(&mt, &mtime))
+        bad_size:
+            STD::fprintf(stderr, "Bad size specification: %s\n", optarg);
+            STD::fflush(stderr);
+            usage();
+        }
+        break;
+
+    case LO_TYPE:
+        // Change only the files, or only the directories
+        if (STD::strcmp(optarg, "f") == 0)
+            m_plan.setType(false);
+        else if (STD::strcmp(optarg, "d") == 0)
+            m_plan.setType(true);
+        else
         {
-            STD::fprintf(stderr, "Can't convert file timestamp for: %s\n",
-                fname);
+            STD::fprintf(stderr, "Bad file type: %s\n", optarg);
             STD::fflush(stderr);
-            err = RC_TIME;
-            goto fail;
+            usage();
         }
+        break;
 
-        if (m_opt_localTime)
+    case LO_EXCLUDE:
+        // Do not change the files matching a filename pattern
+        if (not m_plan.addExclude(optarg))
+        {
+            STD::fprintf(stderr, "Too many '--exclude' patterns: %s\n",
+                optarg);
+            STD::fflush(stderr);
+            usage();
+        }
+        break;
+
+    case LO_CLIENT:
+        // Send requests to a server
+        m_opt_clientName = optarg;
+        break;
+
+    case LO_TAR:
+        // Change the timestamps of the members of tar archives
+        m_opt_tar = true;
+        break;
+
+    case LO_WATCH:
+        // Watch for new and changed files
+        m_opt_watch = true;
+        break;
+
+    case LO_QUEUE:
+        // Change several files at a time
+        m_opt_queueDepth = ChtimeExecutor::QUEUE_DEPTH;
+        if (optarg != NULL)
         {
-            if (not ::LocalFileTimeToFileTime(&mtime, &mtime))
+            char	c;
+
+            if (STD::sscanf(optarg, "%d%c", &m_opt_queueDepth, &c) != 1
+                or  m_opt_queueDepth < 1
+                or  m_opt_queueDepth > ChtimeExecutor::QUEUE_MAX)
             {
-                STD::fprintf(stderr, "Can't convert local timestamp for: %s\n",
-                    fname);
+                STD::fprintf(stderr, "Bad queue depth: %s\n", optarg);
                 STD::fflush(stderr);
-                err = RC_TIME;
-                goto fail;
+                usage();
             }
         }
-    }
+        break;
 
-    // Update the file's modification timestamp
-    if (not ::SetFileTime(h, (FILETIME *) NULL, (FILETIME *) NULL, &mtime))
-    {
-        STD::fprintf(stderr, "Can't modify timestamp for: %s\n", fname);
-        STD::fflush(stderr);
-        err = RC_TIME;
-        goto fail;
-    }
+    case LO_PRESERVE:
+        // Keep the timestamps of the directories of created files
+        m_opt_preserveDirs = true;
+        break;
 
-    // Display the change
-    if (m_opt_verbose)
-    {
-        // Retrieve the file's new timestamp
-        if (not ::GetFileTime(h, (FILETIME *) NULL, (FILETIME *) NULL, &mtime))
+    case LO_DIRCACHE:
+        // Open files relative to cached directory handles
+        m_opt_dirCache = ChtimeDirCache::DIR_CACHE_SIZE;
+        if (optarg != NULL)
         {
-            STD::fprintf(stderr, "Can't get new timestamp for: %s\n", fname);
-            STD::fflush(stderr);
-            err = RC_TIME;
-            goto fail;
+            char	c;
+
+            if (STD::sscanf(optarg, "%d%c", &m_opt_dirCache, &c) != 1
+                or  m_opt_dirCache < 1
+                or  m_opt_dirCache > ChtimeDirCache::DIR_CACHE_MAX)
+            {
+                STD::fprintf(stderr, "Bad directory cache size: %s\n",
+                    optarg);
+                STD::fflush(stderr);
+                usage();
+            }
         }
+        break;
+
+    case LO_CLAMP:
+        // Clamp timestamps later than a given time
+        m_opt_clamp = true;
+        m_opt_clampSpec = optarg;
+        break;
 
-        if (m_opt_localTime)
+    case LO_SHARD:
+        // Change only the files belonging to a given shard
         {
-            if (not ::FileTimeToLocalFileTime(&mtime, &mtime))
+            char	slash;
+            char	extra;
+
+            if (STD::sscanf(optarg, "%lu%c%lu%c", &m_plan.m_shardIdx, &slash,
+                    &m_plan.m_shardCnt, &extra) != 3
+                or  slash != '/'
+                or  m_plan.m_shardCnt < 1
+                or  m_plan.m_shardIdx >= m_plan.m_shardCnt)
             {
-                STD::fprintf(stderr, "Can't get local timestamp for: %s\n",
-                    fname);
+                STD::fprintf(stderr, "Bad shard specification: %s\n",
+                    optarg);
                 STD::fflush(stderr);
-                err = RC_TIME;
-                goto fail;
+                usage();
             }
         }
-
-        // Display the file's new timestamp
-        ::FileTimeToSystemTime(&mtime, &mt);
-        STD::fprintf(stdout, "%04d-%02d-%02d %02d:%02d:%02d.%03d  ",
-            mt.wYear,
-            mt.wMonth,
-            mt.wDay,
-            mt.wHour,
-            mt.wMinute,
-            mt.wSecond,
-            mt.wMilliseconds);
-        STD::fprintf(stdout, "%s\n", fname);
-        STD::fflush(stdout);
+        break;
     }
 
-    // Done, clean up
-    ::CloseHandle(h);
-    h = (HANDLE) NULL;
+    return n;
+}
 
-    return RC_OKAY;
 
-fail:
-    // Failure, clean up
-    if (h != (HANDLE) NULL)
-        ::CloseHandle(h);
-    h = (HANDLE) NULL;
+//------------------------------------------------------------------------------
+// Program::hashArgs()
+//	Compute a hash of all of the filename args, which identifies the work
+//	recorded by a checkpoint.
+//
+// Param	argc
+//	The size of array 'argv'.
+//
+// Param	argv
+//	The filename args.
+//
+// Returns
+//	The hash value of the filename args, in order.
+//------------------------------------------------------------------------------
 
-    return err;
+/*static*/
+unsigned long Program::hashArgs(int argc, const char *const *argv)
+{
+    unsigned long	h =	2166136261UL;
+    int			i;
+
+    h = ((h ^ (unsigned long) argc) * 16777619UL) & 0xFFFFFFFFUL;
+    for (i = 0;  i < argc;  i++)
+        h = ((h ^ ChtimePlan::hashPath(argv[i])) * 16777619UL) & 0xFFFFFFFFUL;
+
+    return h;
 }
 
 
 //------------------------------------------------------------------------------
-// Program::changeFiles()
-//	Change the timestamp of several files matching a wildcarded filename.
+// Program::readCheckpoint()
+//	Read the cursor recorded in a resume checkpoint file.
+//
+//	A checkpoint file contains two lines of the form:
+//	    "chtime-checkpoint HASH ARG MATCH"
+//	    "NAME"
+//	where 'HASH' is the hash of all of the filename args (in hexadecimal),
+//	'ARG' is the index of the filename arg being processed, 'MATCH' is the
+//	number of filenames matching it that have already been changed, and
+//	'NAME' is the last of those filenames (or empty if there are none).
 //
-// Param	pat
-//	Filename pattern matching the filenames to change.
+// Param	argc
+//	The size of array 'argv'.
+//
+// Param	argv
+//	The filename args.
 //
 // Returns
 //	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
 //	status codes on failure.
 //------------------------------------------------------------------------------
 
-int Program::changeFiles(const char *pat)
+int Program::readCheckpoint(int argc, const char *const *argv)
 {
-    int			err = RC_OKAY;
-    HANDLE		fh;
-    WIN32_FIND_DATA	fs;
-    char *		fnamep;
-    char		fpath[32*1024+1];
+    STD::FILE *		fp;
+    char *		buf =	NULL;
+    unsigned long	hash;
+    int			arg;
+    long		match;
+    char		c;
+    int			len;
+    int			rc =	RC_OKAY;
+
+    // Read the checkpoint file
+    fp = STD::fopen(m_opt_resumeName, "r");
+    if (fp == NULL)
+    {
+        STD::fprintf(stderr, "Can't read: %s\n", m_opt_resumeName);
+        STD::fflush(stderr);
+        return RC_READ;
+    }
 
-    // Set up the filename search
-    fh = ::FindFirstFile((LPCSTR) pat, (WIN32_FIND_DATA *) &fs);
+    buf = new char[CKPT_NAME_MAX+2];
+    if (STD::fgets(buf, CKPT_NAME_MAX+2, fp) == NULL
+        or  STD::sscanf(buf, "chtime-checkpoint %lx %d %ld%c", &hash, &arg,
+                &match, &c) != 4
+        or  c != '\n')
+        goto bad;
+
+    // Read the name of the last completed match
+    if (STD::fgets(buf, CKPT_NAME_MAX+2, fp) == NULL)
+        goto bad;
+    len = (int) STD::strcspn(buf, "\r\n");
+    if (buf[len] == '\0')
+        goto bad;
+    buf[len] = '\0';
+
+    // Verify that the checkpoint belongs to the same filename args
+    if (hash != m_ckpt_hash  or  arg < 0  or  match < 0  or  arg > argc)
+    {
+        STD::fprintf(stderr, "Checkpoint does not match the filenames: %s\n",
+            m_opt_resumeName);
+        STD::fflush(stderr);
+        rc = RC_READ;
+        goto done;
+    }
 
-    if (fh == INVALID_HANDLE_VALUE)
+    m_resume_arg = arg;
+    m_resume_match = match;
+    if (buf[0] != '\0')
     {
-        if (m_opt_create)
-        {
-            const char *	fname;
-            HANDLE		h;
+        m_resume_name = buf;
+        buf = NULL;
+    }
+    goto done;
 
-            // Create a new file with the current date/time
-            fname = pat;
-            h = ::CreateFile(
-                    (LPCSTR) fname,
-                    (DWORD) GENERIC_WRITE,
-                    (DWORD) FILE_SHARE_READ,
-                    (LPSECURITY_ATTRIBUTES) NULL,
-                    (DWORD) CREATE_NEW,
-                    (DWORD) 0,
-                    (HANDLE) NULL);
+bad:
+    // Malformed checkpoint
+    STD::fprintf(stderr, "Bad checkpoint: %s\n", m_opt_resumeName);
+    STD::fflush(stderr);
+    rc = RC_READ;
 
-            if (h == INVALID_HANDLE_VALUE)
-            {
-                // Can't create a new file (possibly a wildcard name)
-                STD::fprintf(stderr, "Can't create: %s\n", fname);
-                STD::fflush(stderr);
-                err = RC_CREATE;
-            }
-            else
-            {
-                ::CloseHandle(h);
+done:
+    // Clean up
+    STD::fclose(fp);
+    fp = NULL;
+    delete[] buf;
+    buf = NULL;
 
-                // Modify the timestamp of the new file
-                err = changeFile(fname);
-            }
+    return rc;
+}
 
-            return err;
-        }
-        else
-        {
-            // Can't find any matching filenames
-            STD::fprintf(stderr, "Can't find: %s\n", pat);
-            STD::fflush(stderr);
-            fh = (HANDLE) NULL;
-            err = RC_FIND;
-            goto fail;
-        }
-    }
 
-    // Initialize the full filename path
-    {
-        // Copy and normalize the filename pattern
-        for (int j = 0;  pat[j] != '\0';  j++)
-        {
-            fpath[j] = pat[j];
-            if (fpath[j] == '/')
-                fpath[j] = '\\';
-        }
+//------------------------------------------------------------------------------
+// Program::writeCheckpoint()
+//	Record the current cursor in the checkpoint file.
+//
+//	The checkpoint is written to a temporary file which then replaces the
+//	checkpoint file, so that an interrupted run always leaves a complete
+//	checkpoint behind.
+//
+// Param	force
+//	If false, the checkpoint is only written if at least 'CKPT_INTERVAL'
+//	milliseconds have elapsed since the last one.
+//
+// Returns
+//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
+//	status codes on failure.
+//------------------------------------------------------------------------------
 
-        // Truncate the leading directory path prefix
-        fnamep = STD::strrchr(fpath, '\\');
-        if (fnamep == NULL)
-            fnamep = fpath;
-        else
-            fnamep++;
-        *fnamep = '\0';
-    }
+int Program::writeCheckpoint(bool force)
+{
+    HANDLE	h;
+    DWORD	now;
+    DWORD	n;
+    int		len;
 
-    // Search for one or more matching filenames
-    for (;;)
+    // Check the checkpoint interval
+    if (m_opt_ckptName == NULL)
+        return RC_OKAY;
+
+    now = ::GetTickCount();
+    if (not force  and  now - m_ckpt_tick < CKPT_INTERVAL)
+        return RC_OKAY;
+
+    m_ckpt_tick = now;
+
+    // Set up the checkpoint buffers
+    if (m_ckpt_buf == NULL)
     {
-        const char *	fname;
-        int		rc;
+        m_ckpt_buf = new char[CKPT_NAME_MAX+100];
+        m_ckpt_tmp = new char[CKPT_NAME_MAX+1];
+        STD::sprintf(m_ckpt_tmp, "%.*s.tmp", (int) CKPT_NAME_MAX-4,
+            m_opt_ckptName);
+    }
 
-        // Change the timestamp of the next matching filename
-        fname = (char *) fs.cFileName;
-        STD::strcpy(fnamep, fname);
-        rc = changeFile(fpath);
+    // Format the cursor
+    len = STD::sprintf(m_ckpt_buf, "chtime-checkpoint %08lx %d %ld\n%s\n",
+        m_ckpt_hash, m_ckpt_arg, m_ckpt_match, m_ckpt_name);
 
-        if (err == RC_OKAY)
-            err = rc;
+    // Write the cursor to a temporary file
+    h = ::CreateFile(
+            (LPCSTR) m_ckpt_tmp,
+            (DWORD) GENERIC_WRITE,
+            (DWORD) 0,
+            (LPSECURITY_ATTRIBUTES) NULL,
+            (DWORD) CREATE_ALWAYS,
+            (DWORD) FILE_ATTRIBUTE_NORMAL,
+            (HANDLE) NULL);
 
-        // Search for the next matching filename
-        if (not ::FindNextFile(fh, (WIN32_FIND_DATA *) &fs))
-            break;
+    if (h == INVALID_HANDLE_VALUE)
+        goto fail;
+
+    if (not ::WriteFile(h, m_ckpt_buf, (DWORD) len, &n, NULL)
+        or  n != (DWORD) len)
+    {
+        ::CloseHandle(h);
+        goto fail;
     }
+    ::CloseHandle(h);
 
-    // Clean up
-    ::FindClose(fh);
-    fh = (HANDLE) NULL;
+    // Replace the checkpoint file
+    if (not ::MoveFileEx((LPCSTR) m_ckpt_tmp, (LPCSTR) m_opt_ckptName,
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+        goto fail;
 
-    return err;
+    return RC_OKAY;
 
 fail:
-    // Failure, clean up
-    if (fh != (HANDLE) NULL)
-        ::FindClose(fh);
-    fh = (HANDLE) NULL;
-
-    return err;
+    // Failure
+    STD::fprintf(stderr, "Can't write checkpoint: %s\n", m_opt_ckptName);
+    STD::fflush(stderr);
+    return RC_WRITE;
 }
 
 
 //------------------------------------------------------------------------------
-// Program::main()
+// Program::showTime()
+//	Display the new timestamp of a file.
 //
-// Param	argc
-//	The size of array 'argv'.
+// Param	fname
+//	The name of the file.
 //
-// Param	argv
-//	The command line argument strings.
+// Param	mtime
+//	The new modification timestamp (UTC) of the file.
 //
 // Returns
 //	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
 //	status codes on failure.
 //------------------------------------------------------------------------------
 
-int Program::main(int argc, const char *const *argv)
+int Program::showTime(const char *fname, const FILETIME *mtime) const
 {
-    HANDLE	h =	(HANDLE) NULL;
-    int		err =	RC_OKAY;
-    int		i;
+    char	buf[ChtimePlan::TIME_LEN+1];
+
+    // Convert the timestamp into a displayable form
+    if (not ChtimePlan::formatTime(mtime, m_plan.m_localTime, buf))
+    {
+        STD::fprintf(stderr, "Can't get local timestamp for: %s\n", fname);
+        STD::fflush(stderr);
+        return RC_TIME;
+    }
+
+    // Display the file's new timestamp
+    STD::fprintf(stdout, "%s  %s\n", buf, fname);
+    STD::fflush(stdout);
+    return RC_OKAY;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::showResult()
+//	Display the outcome of changing the timestamp of a file.
+//
+//	Failures are displayed as error messages.  The new timestamp of a
+//	changed file is displayed if verbose output is enabled, except when
+//	watching for changed files and the timestamp was already correct.
+//
+// Param	res
+//	The outcome for the file.
+//
+// Returns
+//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
+//	status codes on failure.
+//------------------------------------------------------------------------------
+
+int Program::showResult(const ChtimeResult *res) const
+{
+    if (res->rc != RC_OKAY)
+    {
+        // Display the failure
+        STD::fprintf(stderr, "%s: %s\n", res->msg, res->fname);
+        STD::fflush(stderr);
+        return res->rc;
+    }
+
+    // Display the file's new timestamp
+    if (m_opt_verbose  and  not res->skipped
+        and  (res->changed  or  not m_watching))
+        return showTime(res->fname, &res->mtime);
+
+    return RC_OKAY;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::changeFile()
+//	Change the timestamp of a filename.
+//
+// Param	fname
+//	The name of a file to change.
+//
+// Returns
+//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
+//	status codes on failure.
+//------------------------------------------------------------------------------
+
+int Program::changeFile(const char *fname)
+{
+    ChtimeResult	res;
+
+    // Change the file, and display the outcome
+    m_exec->changeFile(fname, &res);
+    return showResult(&res);
+}
+
+
+//------------------------------------------------------------------------------
+// Program::report()
+//	Display the outcome for a file found by the executor, or list or count
+//	its timestamp.
+//
+// Param	res
+//	The outcome for the file.
+//
+// Returns
+//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
+//	status codes on failure.
+//------------------------------------------------------------------------------
+
+int Program::report(const ChtimeResult *res)
+{
+    // Display the file's timestamp, or count it within the histogram
+    if (res->rc == RC_OKAY  and  m_opt_list)
+        return showTime(res->fname, &res->mtime);
+    if (res->rc == RC_OKAY  and  m_opt_histBucket != HB_NONE)
+        return countFile(res);
+
+    // Display the outcome
+    return showResult(res);
+}
+
+
+//------------------------------------------------------------------------------
+// Program::progress()
+//	Record the progress of the search for the current filename arg, and
+//	write a checkpoint if one is due.
+//
+// Param	fname
+//	The name of the last matching file whose outcome has been displayed.
+//
+// Param	match
+//	The number of matching files whose outcomes have been displayed.
+//------------------------------------------------------------------------------
+
+void Program::progress(const char *fname, long match)
+{
+    m_ckpt_match = match;
+    if (m_ckpt_name != NULL)
+        STD::sprintf(m_ckpt_name, "%.*s", (int) CKPT_NAME_MAX, fname);
+    writeCheckpoint(false);
+}
+
+
+//------------------------------------------------------------------------------
+// Program::addWatchName()
+//	Add a changed filename to, or remove a deleted filename from, the batch
+//	of filenames to change.
+//
+// Param	fname
+//	The name of a created, written, or deleted file.
+//
+// Param	add
+//	True if the file was created or written, false if it was deleted or
+//	renamed.
+//
+// Returns
+//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
+//	status codes if the batch was full and could not all be changed.
+//------------------------------------------------------------------------------
+
+int Program::addWatchName(const char *fname, bool add)
+{
+    int		rc =	RC_OKAY;
+    int		i;
+
+    // Look for the filename within the batch
+    for (i = 0;  i < m_watch_cnt;  i++)
+    {
+        if (STD::strcmp(&m_watch_names[i*(MAX_PATH+1)], fname) == 0)
+            break;
+    }
+
+    if (not add)
+    {
+        // Remove the deleted filename from the batch
+        if (i < m_watch_cnt)
+        {
+            m_watch_cnt--;
+            STD::strcpy(&m_watch_names[i*(MAX_PATH+1)],
+                &m_watch_names[m_watch_cnt*(MAX_PATH+1)]);
+            m_watch_tries[i] = m_watch_tries[m_watch_cnt];
+        }
+        return RC_OKAY;
+    }
+
+    // Add the changed filename to the batch, once
+    if (i < m_watch_cnt)
+        return RC_OKAY;
+
+    if (m_watch_cnt >= WATCH_BATCH)
+        rc = flushWatchNames(false);
+    STD::strcpy(&m_watch_names[m_watch_cnt*(MAX_PATH+1)], fname);
+    m_watch_tries[m_watch_cnt] = 0;
+    m_watch_cnt++;
+    return rc;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::flushWatchNames()
+//	Change the timestamps of the batched changed filenames.
+//
+//	A file that is still open by the program writing it can't be changed
+//	(with a sharing violation), and is kept in the batch to be retried after
+//	the next quiet period, up to 'WATCH_RETRIES' times.
+//
+// Param	retry
+//	True if files that can't be changed because they are open are to be
+//	kept for a retry, false if they are to be reported as failures.
+//
+// Returns
+//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
+//	status codes on failure.
+//------------------------------------------------------------------------------
+
+int Program::flushWatchNames(bool retry)
+{
+    int		err =	RC_OKAY;
+    int		keep =	0;
+    int		i;
+
+    for (i = 0;  i < m_watch_cnt;  i++)
+    {
+        const char *	fname;
+        ChtimeResult	res;
+        int		rc;
+
+        // Change the timestamp of the next batched filename
+        fname = &m_watch_names[i*(MAX_PATH+1)];
+        if (not m_plan.inShard(fname))
+            continue;
+
+        m_exec->changeFile(fname, &res);
+
+        // Keep the file for a retry if it is still open
+        if (res.rc == ChtimePlan::RC_WRITE
+            and  ::GetLastError() == ERROR_SHARING_VIOLATION
+            and  retry  and  m_watch_tries[i] < WATCH_RETRIES)
+        {
+            if (keep != i)
+                STD::strcpy(&m_watch_names[keep*(MAX_PATH+1)], fname);
+            m_watch_tries[keep] = m_watch_tries[i] + 1;
+            keep++;
+            continue;
+        }
+
+        // Display the outcome
+        rc = showResult(&res);
+        if (err == RC_OKAY)
+            err = rc;
+    }
+
+    m_watch_cnt = keep;
+    return err;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::watchFiles()
+//	Change the timestamps of files matching wildcarded filenames as they are
+//	created or written, until the program is interrupted.
+//
+//	Notifications for each directory are collected until no more arrive for
+//	'WATCH_SETTLE' milliseconds (or for at most 'WATCH_DELAY' milliseconds),
+//	so that a burst of writes to a file results in a single change.
+//
+// Param	argc
+//	The size of array 'argv'.
+//
+// Param	argv
+//	The filename args.
+//
+// Returns
+//	The first of the 'Program::RC_XXX' status codes for the files that could
+//	not be changed, or for the failure that stopped the watch.
+//------------------------------------------------------------------------------
+
+int Program::watchFiles(int argc, const char *const *argv)
+{
+    int		err =	RC_OKAY;
+    Watch *	watch;
+    HANDLE	evs[MAXIMUM_WAIT_OBJECTS];
+    DWORD	first =	0;
+    int		n;
+    int		i;
+
+    // Check args
+    if (argc > MAXIMUM_WAIT_OBJECTS)
+    {
+        STD::fprintf(stderr, "Too many filenames to watch\n");
+        STD::fflush(stderr);
+        return RC_USAGE;
+    }
+
+    // Set up the batch of changed filenames
+    if (m_watch_names == NULL)
+    {
+        m_watch_names = new char[WATCH_BATCH*(MAX_PATH+1)];
+        m_watch_tries = new int[WATCH_BATCH];
+    }
+    m_watch_cnt = 0;
+    m_watching = true;
+
+    // Open the directory containing each filename pattern
+    watch = new Watch[argc];
+    for (n = 0;  n < argc;  n++)
+    {
+        Watch *		w;
+        int		len;
+        const char *	dir;
+
+        w = &watch[n];
+        STD::memset(&w->ov, 0, sizeof(w->ov));
+        w->dir = INVALID_HANDLE_VALUE;
+
+        // Split the filename pattern into its directory and name parts,
+        // the same way as the executor does
+        len = ChtimePlan::splitPath(argv[n], w->path, MAX_PATH);
+        if (len < 0)
+        {
+            STD::fprintf(stderr, "Filename too long to watch: %s\n", argv[n]);
+            STD::fflush(stderr);
+            err = RC_USAGE;
+            goto done;
+        }
+        w->pat = argv[n] + len;
+
+        dir = (w->path[0] != '\0' ? w->path : ".");
+        w->dir = ::CreateFile(
+                (LPCSTR) dir,
+                (DWORD) FILE_LIST_DIRECTORY,
+                (DWORD) FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                (LPSECURITY_ATTRIBUTES) NULL,
+                (DWORD) OPEN_EXISTING,
+                (DWORD) FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                (HANDLE) NULL);
+
+        if (w->dir == INVALID_HANDLE_VALUE)
+        {
+            STD::fprintf(stderr, "Can't watch: %s\n", dir);
+            STD::fflush(stderr);
+            err = RC_READ;
+            goto done;
+        }
+
+        // Request the first notifications
+        w->ov.hEvent = evs[n] = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+        if (not ::ReadDirectoryChangesW(w->dir, w->buf, sizeof(w->buf), FALSE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                NULL, &w->ov, NULL))
+        {
+            STD::fprintf(stderr, "Can't watch: %s\n", dir);
+            STD::fflush(stderr);
+            ::CloseHandle(w->ov.hEvent);
+            err = RC_READ;
+            goto done;
+        }
+    }
+
+    // Wait for changed files
+    for (;;)
+    {
+        Watch *		w;
+        DWORD		rc;
+        DWORD		len;
+        DWORD		wait;
+        int		st;
+
+        // Wait for the next notifications, or until the batch is due
+        wait = INFINITE;
+        if (m_watch_cnt > 0)
+        {
+            wait = ::GetTickCount() - first;
+            wait = (wait < WATCH_DELAY ? WATCH_DELAY - wait : 0);
+            if (wait > WATCH_SETTLE)
+                wait = WATCH_SETTLE;
+        }
+
+        // Change an overdue batch without waiting, since a directory with
+        // steady changes would never let the wait time out
+        rc = WAIT_TIMEOUT;
+        if (wait > 0)
+            rc = ::WaitForMultipleObjects(n, evs, FALSE, wait);
+        if (rc == WAIT_TIMEOUT)
+        {
+            // Change the batched filenames, retrying any still open after
+            // the next quiet period
+            st = flushWatchNames(true);
+            if (err == RC_OKAY)
+                err = st;
+            st = restoreDirTimes();
+            if (err == RC_OKAY)
+                err = st;
+            first = ::GetTickCount();
+            continue;
+        }
+
+        i = (int) (rc - WAIT_OBJECT_0);
+        if (rc == WAIT_FAILED  or  i < 0  or  i >= n)
+        {
+            err = RC_READ;
+            goto done;
+        }
+
+        // Collect the changed filenames
+        w = &watch[i];
+        if (m_watch_cnt == 0)
+            first = ::GetTickCount();
+
+        if (not ::GetOverlappedResult(w->dir, &w->ov, &len, FALSE))
+            len = 0;
+
+        if (len == 0)
+        {
+            // Notifications were lost, so rescan the whole directory
+            m_watching = false;
+            st = m_exec->changePattern(argv[i], this, 0, NULL);
+            m_watching = true;
+            if (err == RC_OKAY)
+                err = st;
+            st = restoreDirTimes();
+            if (err == RC_OKAY)
+                err = st;
+        }
+        else
+        {
+            const BYTE *	p;
+
+            for (p = (const BYTE *) w->buf;  ;  )
+            {
+                const FILE_NOTIFY_INFORMATION *	fni;
+                char		name[MAX_PATH+1];
+                char		fpath[2*MAX_PATH+1];
+                int		nlen;
+
+                // Convert the next filename
+                fni = (const FILE_NOTIFY_INFORMATION *) p;
+                nlen = ::WideCharToMultiByte(CP_ACP, 0, fni->FileName,
+                    fni->FileNameLength/sizeof(WCHAR), name, MAX_PATH,
+                    NULL, NULL);
+                name[nlen] = '\0';
+
+                if (nlen > 0  and  ChtimePlan::matchName(w->pat, name))
+                {
+                    STD::sprintf(fpath, "%s%s", w->path, name);
+                    st = RC_OKAY;
+                    if (STD::strlen(fpath) <= MAX_PATH)
+                        st = addWatchName(fpath,
+                            fni->Action != FILE_ACTION_REMOVED
+                            and  fni->Action != FILE_ACTION_RENAMED_OLD_NAME);
+                    if (err == RC_OKAY)
+                        err = st;
+                }
+
+                if (fni->NextEntryOffset == 0)
+                    break;
+                p += fni->NextEntryOffset;
+            }
+        }
+
+        // Request the next notifications
+        ::ResetEvent(w->ov.hEvent);
+        if (not ::ReadDirectoryChangesW(w->dir, w->buf, sizeof(w->buf), FALSE,
+                FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE,
+                NULL, &w->ov, NULL))
+        {
+            STD::fprintf(stderr, "Can't watch: %s\n", argv[i]);
+            STD::fflush(stderr);
+            err = RC_READ;
+            goto done;
+        }
+    }
+
+done:
+    // Clean up
+    for (i = 0;  i < n;  i++)
+    {
+        ::CancelIo(watch[i].dir);
+        ::CloseHandle(watch[i].ov.hEvent);
+        ::CloseHandle(watch[i].dir);
+    }
+    if (n < argc  and  watch[n].dir != INVALID_HANDLE_VALUE)
+        ::CloseHandle(watch[n].dir);
+
+    delete[] watch;
+    m_watching = false;
+    return err;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::restoreDirTimes()
+//	Restore the recorded timestamps of the directories in which files have
+//	been created so far, if '--preserve-dir-times' was specified.
+//
+// Returns
+//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
+//	status codes on failure.
+//------------------------------------------------------------------------------
+
+int Program::restoreDirTimes()
+{
+    const char *	dname;
+    int			rc;
+
+    if (m_times == NULL)
+        return RC_OKAY;
+
+    rc = m_times->restore(&dname);
+    if (rc != RC_OKAY)
+    {
+        STD::fprintf(stderr, "Can't restore timestamps of: %s\n", dname);
+        STD::fflush(stderr);
+    }
+
+    return rc;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::ctrlHandler()
+//	Console control handler, which restores the recorded timestamps of the
+//	directories of the created files when the program is interrupted (e.g.,
+//	by Ctrl-C while watching).
+//
+// Param	type
+//	The control event, 'CTRL_XXX_EVENT'.
+//
+// Returns
+//	False, so that the default handler then terminates the program.
+//------------------------------------------------------------------------------
+
+/*static*/
+ChtimeDirTimes *volatile	Program::s_dirTimes =	NULL;
+
+/*static*/
+BOOL WINAPI Program::ctrlHandler(DWORD type)
+{
+    ChtimeDirTimes *	times;
+    const char *	dname;
+
+    times = s_dirTimes;
+    if (times != NULL  and  times->restore(&dname) != RC_OKAY)
+    {
+        STD::fprintf(stderr, "Can't restore timestamps of: %s\n", dname);
+        STD::fflush(stderr);
+    }
+
+    return FALSE;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::countFile()
+//	Count the timestamp of a file within the histogram.
+//
+// Param	res
+//	The outcome for the file, holding its timestamp.
+//
+// Returns
+//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
+//	status codes on failure.
+//------------------------------------------------------------------------------
+
+int Program::countFile(const ChtimeResult *res)
+{
+    FILETIME		lt;
+    SYSTEMTIME		mt;
+    unsigned long	key;
+    int			i;
+
+    // Determine the histogram bucket of the timestamp
+    lt = res->mtime;
+    if (m_plan.m_localTime
+        and  not ::FileTimeToLocalFileTime(&res->mtime, &lt))
+    {
+        STD::fprintf(stderr, "Can't get local timestamp for: %s\n",
+            res->fname);
+        STD::fflush(stderr);
+        return RC_TIME;
+    }
+    ::FileTimeToSystemTime(&lt, &mt);
+
+    key = mt.wYear*1000000UL;
+    if (m_opt_histBucket >= HB_MONTH)
+        key += mt.wMonth*10000UL;
+    if (m_opt_histBucket >= HB_DAY)
+        key += mt.wDay*100UL;
+    if (m_opt_histBucket >= HB_HOUR)
+        key += mt.wHour;
+
+    // Enlarge the hash table when it becomes half full, rehashing the
+    // buckets (a key of zero marks an empty slot, since no year is zero)
+    if (m_histCnt*2 >= m_histSize)
+    {
+        HistBucket *	h;
+        int		size;
+
+        size = (m_histSize == 0 ? HIST_INIT : m_histSize*2);
+        h = new HistBucket[size];
+        STD::memset(h, 0, size*sizeof(HistBucket));
+
+        for (i = 0;  i < m_histSize;  i++)
+        {
+            int		j;
+
+            if (m_hist[i].key == 0)
+                continue;
+            j = hashBucket(m_hist[i].key, size);
+            while (h[j].key != 0)
+                j = (j+1) & (size-1);
+            h[j] = m_hist[i];
+        }
+
+        delete[] m_hist;
+        m_hist = h;
+        m_histSize = size;
+    }
+
+    // Locate the bucket, adding it if it is new
+    i = hashBucket(key, m_histSize);
+    while (m_hist[i].key != 0  and  m_hist[i].key != key)
+        i = (i+1) & (m_histSize-1);
+
+    if (m_hist[i].key == 0)
+    {
+        m_hist[i].key = key;
+        m_hist[i].count = 0;
+        m_histCnt++;
+    }
+
+    m_hist[i].count++;
+    return RC_OKAY;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::showHistogram()
+//	Display the histogram of the listed file timestamps.
+//
+// Notes
+//	The buckets are sorted by key in place, which leaves 'm_hist' unusable
+//	as a hash table afterwards.
+//------------------------------------------------------------------------------
+
+void Program::showHistogram()
+{
+    unsigned long	total =	0;
+    int			n =	0;
+    int			i;
+
+    // Gather the used buckets, and sort them by time
+    for (i = 0;  i < m_histSize;  i++)
+    {
+        if (m_hist[i].key != 0)
+            m_hist[n++] = m_hist[i];
+    }
+    if (n > 1)
+        STD::qsort(m_hist, n, sizeof(HistBucket), compareBuckets);
+
+    for (i = 0;  i < n;  i++)
+    {
+        unsigned long	k;
+
+        // Display the next bucket
+        k = m_hist[i].key;
+        switch (m_opt_histBucket)
+        {
+        case HB_YEAR:
+            STD::fprintf(stdout, "%04lu           ", k/1000000);
+            break;
+
+        case HB_MONTH:
+            STD::fprintf(stdout, "%04lu-%02lu        ", k/1000000,
+                k/10000%100);
+            break;
+
+        case HB_DAY:
+            STD::fprintf(stdout, "%04lu-%02lu-%02lu     ", k/1000000,
+                k/10000%100, k/100%100);
+            break;
+
+        default:
+            STD::fprintf(stdout, "%04lu-%02lu-%02lu %02lu  ", k/1000000,
+                k/10000%100, k/100%100, k%100);
+            break;
+        }
+
+        STD::fprintf(stdout, "%10lu\n", m_hist[i].count);
+        total += m_hist[i].count;
+    }
+
+    STD::fprintf(stdout, "total           %10lu\n", total);
+    STD::fflush(stdout);
+}
+
+
+//------------------------------------------------------------------------------
+// Program::compareBuckets()
+//	Compare two histogram buckets by their keys, for 'qsort()'.
+//
+// Returns
+//	A negative value, zero, or a positive value if the key of 'a' is less
+//	than, equal to, or greater than the key of 'b'.
+//------------------------------------------------------------------------------
+
+/*static*/
+int Program::compareBuckets(const void *a, const void *b)
+{
+    unsigned long	ka;
+    unsigned long	kb;
+
+    ka = ((const HistBucket *) a)->key;
+    kb = ((const HistBucket *) b)->key;
+    return (ka < kb ? -1 : ka > kb ? 1 : 0);
+}
+
+
+//------------------------------------------------------------------------------
+// Program::hashBucket()
+//	Determine the hash table slot of a histogram bucket key.
+//
+// Param	key
+//	The bucket key, as 'YYYYMMDDhh'.  The low digits are zero for the
+//	larger bucket sizes, so the key is mixed before it is reduced.
+//
+// Param	size
+//	The size of the hash table, which is a power of 2.
+//
+// Returns
+//	The first slot to probe for the key.
+//------------------------------------------------------------------------------
+
+/*static*/
+int Program::hashBucket(unsigned long key, int size)
+{
+    unsigned long	h;
+
+    h = key ^ (key >> 13);
+    h *= 2654435761UL;
+    h ^= (h >> 16);
+    return (int) (h & (unsigned long) (size-1));
+}
+
+
+//------------------------------------------------------------------------------
+// Program::readMessage()
+//	Read a complete message from a message-mode named pipe.
+//
+// Param	pipe
+//	Handle of the named pipe.
+//
+// Param	buf
+//	Pointer to a buffer allocated with 'new[]', which is enlarged (and
+//	replaced) if the message does not fit within it.
+//
+// Param	size
+//	Pointer to the size of buffer 'buf', which is updated if the buffer is
+//	enlarged.
+//
+// Param	len
+//	Pointer to a length, which is set to the length of the message read.
+//
+// Returns
+//	True on success, or false if the pipe was closed or could not be read,
+//	or if the message is longer than 'SERVE_MSG_MAX' bytes.
+//------------------------------------------------------------------------------
+
+/*static*/
+bool Program::readMessage(HANDLE pipe, char **buf, DWORD *size, DWORD *len)
+{
+    DWORD	n;
+
+    *len = 0;
+    for (;;)
+    {
+        // Read the (next part of the) message
+        if (::ReadFile(pipe, *buf + *len, *size - *len, &n, NULL))
+        {
+            *len += n;
+            return true;
+        }
+
+        if (::GetLastError() != ERROR_MORE_DATA)
+            return false;
+        *len += n;
+
+        // Enlarge the buffer to hold the rest of the message, up to the
+        // maximum message size
+        if (*size >= SERVE_MSG_MAX)
+            return false;
+
+        {
+            char *	nbuf;
+            DWORD	nsize;
+
+            nsize = (*size < SERVE_MSG_MAX/2 ? *size*2 : SERVE_MSG_MAX);
+            nbuf = new char[nsize];
+            STD::memcpy(nbuf, *buf, *len);
+            delete[] *buf;
+            *buf = nbuf;
+            *size = nsize;
+        }
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Program::serveThread()
+//	Server worker thread entry point.
+//
+// Param	arg
+//	Pointer to the 'Program' object.
+//
+// Returns
+//	Zero.
+//------------------------------------------------------------------------------
+
+/*static*/
+DWORD WINAPI Program::serveThread(LPVOID arg)
+{
+    ((Program *) arg)->serveClients();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::serveClients()
+//	Serve the requests of clients connected to the server pipe, one client
+//	connection at a time, until the program is terminated.
+//
+//	Each request message consists of a 'ServeRequest' header holding a plan,
+//	followed by the null-terminated names of the files to change.  Each
+//	reply message consists of a 'ServeReply' header, followed by a
+//	'ServeResult' for each of the files.  A client may send any number of
+//	requests over a single connection.
+//------------------------------------------------------------------------------
+
+void Program::serveClients()
+{
+    char *		req;
+    DWORD		reqSize =	SERVE_BUFSIZE;
+    char *		rep;
+    DWORD		repSize =	SERVE_BUFSIZE;
+    const char **	names;
+    ChtimeResult *	res;
+    DWORD		resSize =	0;
+    ChtimeDirCache	cache(m_opt_dirCache);
+
+    req = new char[reqSize];
+    rep = new char[repSize];
+    names = NULL;
+    res = NULL;
+
+    for (;;)
+    {
+        HANDLE	pipe;
+        DWORD	len;
+
+        // Wait for the next client to connect, on the first pipe instance
+        // (created by 'serve()') if no other thread has taken it
+        pipe = (HANDLE) ::InterlockedExchangePointer(&m_servePipe, NULL);
+        if (pipe == NULL)
+            pipe = createPipe(false);
+
+        if (pipe == INVALID_HANDLE_VALUE)
+        {
+            STD::fprintf(stderr, "Can't serve: %s\n", m_pipeName);
+            STD::fflush(stderr);
+            ::Sleep(SERVE_TIMEOUT);
+            continue;
+        }
+
+        if (not ::ConnectNamedPipe(pipe, NULL)
+            and  ::GetLastError() != ERROR_PIPE_CONNECTED)
+        {
+            ::CloseHandle(pipe);
+            continue;
+        }
+
+        // Serve requests from the client
+        while (readMessage(pipe, &req, &reqSize, &len))
+        {
+            const ServeRequest *	hdr;
+            ServeReply *		rh;
+            ServeResult *		rr;
+            const char *		p;
+            DWORD			i;
+            DWORD			n;
+
+            // Verify the request, which holds at least one byte for each of
+            // its filenames
+            hdr = (const ServeRequest *) req;
+            if (len < sizeof(*hdr)  or  hdr->magic != SERVE_MAGIC
+                or  hdr->count > SERVE_NAMES_MAX
+                or  hdr->count > len - sizeof(*hdr))
+                break;
+
+            if (hdr->count > resSize)
+            {
+                delete[] names;
+                delete[] res;
+                resSize = hdr->count;
+                names = new const char *[resSize];
+                res = new ChtimeResult[resSize];
+            }
+
+            // Extract the filenames
+            p = req + sizeof(*hdr);
+            for (i = 0;  i < hdr->count;  i++)
+            {
+                const char *	e;
+
+                e = (const char *) STD::memchr(p, '\0', req + len - p);
+                if (e == NULL)
+                    break;
+                names[i] = p;
+                p = e + 1;
+            }
+            if (i < hdr->count)
+                break;
+
+            // Change the files, as specified by the plan of the request
+            {
+                ChtimePlan	plan;
+
+                plan.m_create =    (hdr->create != 0);
+                plan.m_localTime = (hdr->localTime != 0);
+                plan.m_readBack =  (hdr->readBack != 0);
+                plan.m_year =      hdr->year;
+                plan.m_mon =       hdr->mon;
+                plan.m_mday =      hdr->mday;
+                plan.m_hour =      hdr->hour;
+                plan.m_min =       hdr->min;
+                plan.m_sec =       hdr->sec;
+                plan.m_msec =      hdr->msec;
+                plan.m_useTime =   (hdr->useTime != 0);
+                plan.m_time =      hdr->time;
+                plan.m_clamp =     (hdr->clamp != 0);
+                plan.m_clampTime = hdr->clampTime;
+                plan.m_shardIdx =  hdr->shardIdx;
+                plan.m_shardCnt =  hdr->shardCnt;
+
+                ChtimeExecutor	exec(plan);
+
+                if (m_opt_dirCache > 0)
+                    exec.setDirCache(&cache);
+
+                // Open the files with the access rights of the client, not
+                // those of the server
+                if (not ::ImpersonateNamedPipeClient(pipe))
+                    break;
+                exec.changeFiles(names, (int) hdr->count, res);
+                ::RevertToSelf();
+
+                // Don't hold the client's directories open between requests
+                cache.clear();
+            }
+
+            // Reply with the results
+            n = sizeof(ServeReply) + hdr->count*sizeof(ServeResult);
+            if (n > repSize)
+            {
+                delete[] rep;
+                repSize = n;
+                rep = new char[repSize];
+            }
+
+            rh = (ServeReply *) rep;
+            rh->magic = SERVE_MAGIC;
+            rh->count = hdr->count;
+            rr = (ServeResult *) (rep + sizeof(ServeReply));
+            for (i = 0;  i < hdr->count;  i++)
+            {
+                rr[i].rc = res[i].rc;
+                rr[i].skipped = res[i].skipped;
+                rr[i].changed = res[i].changed;
+                rr[i].mtime = res[i].mtime;
+                STD::sprintf(rr[i].msg, "%.*s", (int) sizeof(rr[i].msg)-1,
+                    res[i].msg != NULL ? res[i].msg : "");
+            }
+
+            if (not ::WriteFile(pipe, rep, n, &len, NULL)  or  len != n)
+                break;
+        }
+
+        // Disconnect the client
+        ::FlushFileBuffers(pipe);
+        ::DisconnectNamedPipe(pipe);
+        ::CloseHandle(pipe);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Program::createPipe()
+//	Create an instance of the server named pipe, which accepts only local
+//	clients.
+//
+// Param	first
+//	True if this is the first instance, in which case creating it fails if
+//	the pipe name is already in use (e.g., by another server).
+//
+// Returns
+//	Handle of the pipe instance, or 'INVALID_HANDLE_VALUE' on failure.
+//------------------------------------------------------------------------------
+
+HANDLE Program::createPipe(bool first)
+{
+    return ::CreateNamedPipe(
+            (LPCSTR) m_pipeName,
+            (DWORD) PIPE_ACCESS_DUPLEX
+                | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+            (DWORD) PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT
+                | PIPE_REJECT_REMOTE_CLIENTS,
+            (DWORD) PIPE_UNLIMITED_INSTANCES,
+            (DWORD) SERVE_BUFSIZE,
+            (DWORD) SERVE_BUFSIZE,
+            (DWORD) 0,
+            (LPSECURITY_ATTRIBUTES) NULL);
+}
 
-    // Parse command line options
-    i = parseOpts(argc, argv);
-    argc -= i;
-    argv += i;
+
+//------------------------------------------------------------------------------
+// Program::serve()
+//	Serve requests from client commands on a named pipe, using a pool of
+//	'SERVE_THREADS' worker threads, until the program is terminated.
+//
+//	The first instance of the pipe is created here, so that the server fails
+//	if the pipe name already belongs to another process, rather than sharing
+//	its clients.  Each request is carried out while impersonating the client.
+//
+// Returns
+//	One of the 'Program::RC_XXX' status codes on failure.
+//------------------------------------------------------------------------------
+
+int Program::serve()
+{
+    HANDLE	th[SERVE_THREADS];
+    int		n;
+
+    // Claim the pipe name
+    m_servePipe = createPipe(true);
+    if (m_servePipe == INVALID_HANDLE_VALUE)
+    {
+        m_servePipe = NULL;
+        STD::fprintf(stderr, "Can't serve: %s\n", m_pipeName);
+        STD::fflush(stderr);
+        return RC_READ;
+    }
+
+    // Start the worker threads
+    for (n = 0;  n < SERVE_THREADS;  n++)
+    {
+        th[n] = ::CreateThread(NULL, 0, serveThread, this, 0, NULL);
+        if (th[n] == NULL)
+            break;
+    }
+
+    if (n == 0)
+    {
+        ::CloseHandle(m_servePipe);
+        m_servePipe = NULL;
+        STD::fprintf(stderr, "Can't serve: %s\n", m_pipeName);
+        STD::fflush(stderr);
+        return RC_READ;
+    }
+
+    if (m_opt_verbose)
+    {
+        STD::fprintf(stdout, "Serving: %s\n", m_pipeName);
+        STD::fflush(stdout);
+    }
+
+    // Wait for the worker threads, which never finish
+    ::WaitForMultipleObjects(n, th, TRUE, INFINITE);
+    return RC_READ;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::requestFiles()
+//	Send a request to change the timestamps of filenames to a server, and
+//	display the results.
+//
+// Param	argc
+//	The size of array 'argv'.
+//
+// Param	argv
+//	The filename args (without wildcards).
+//
+// Returns
+//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
+//	status codes on failure.
+//------------------------------------------------------------------------------
+
+int Program::requestFiles(int argc, const char *const *argv)
+{
+    int			err =	RC_OKAY;
+    HANDLE		pipe;
+    ServeRequest *	hdr;
+    const ServeReply *	rh;
+    const ServeResult *	rr;
+    char *		buf;
+    DWORD		size;
+    DWORD		len;
+    DWORD		mode;
+    DWORD		n;
+    int			i;
 
     // Check args
-    if (argc < 1)
-        usage();
+    if (argc > SERVE_NAMES_MAX)
+    {
+        STD::fprintf(stderr, "Too many filenames for a request\n");
+        STD::fflush(stderr);
+        return RC_USAGE;
+    }
 
-    // Process options
-    if (m_opt_fname != NULL)
+    // Build the request, with the full pathnames of the files
+    size = sizeof(ServeRequest) + argc*(MAX_PATH+1);
+    if (size < SERVE_BUFSIZE)
+        size = SERVE_BUFSIZE;
+    buf = new char[size];
+
+    hdr = (ServeRequest *) buf;
+    hdr->magic =     SERVE_MAGIC;
+    hdr->count =     argc;
+    hdr->create =    m_plan.m_create;
+    hdr->localTime = m_plan.m_localTime;
+    hdr->readBack =  m_plan.m_readBack;
+    hdr->year =      m_plan.m_year;
+    hdr->mon =       m_plan.m_mon;
+    hdr->mday =      m_plan.m_mday;
+    hdr->hour =      m_plan.m_hour;
+    hdr->min =       m_plan.m_min;
+    hdr->sec =       m_plan.m_sec;
+    hdr->msec =      m_plan.m_msec;
+    hdr->useTime =   m_plan.m_useTime;
+    hdr->time =      m_plan.m_time;
+    hdr->clamp =     m_plan.m_clamp;
+    hdr->clampTime = m_plan.m_clampTime;
+    hdr->shardIdx =  m_plan.m_shardIdx;
+    hdr->shardCnt =  m_plan.m_shardCnt;
+
+    pipe = (HANDLE) NULL;
+    len = sizeof(ServeRequest);
+    for (i = 0;  i < argc;  i++)
+    {
+        n = ::GetFullPathName(argv[i], MAX_PATH+1, buf + len, NULL);
+        if (n == 0  or  n > MAX_PATH)
+        {
+            // Don't send a truncated name, which could name another file
+            STD::fprintf(stderr, "Filename too long: %s\n", argv[i]);
+            STD::fflush(stderr);
+            err = RC_USAGE;
+            goto done;
+        }
+        len += n + 1;
+    }
+
+    // Connect to the server
+    for (;;)
     {
-        // Open the existing model file
-        h = ::CreateFile(
-                (LPCSTR) m_opt_fname,
-                (DWORD) GENERIC_READ,
-                (DWORD) FILE_SHARE_READ,
+        pipe = ::CreateFile(
+                (LPCSTR) m_pipeName,
+                (DWORD) GENERIC_READ | GENERIC_WRITE,
+                (DWORD) 0,
                 (LPSECURITY_ATTRIBUTES) NULL,
                 (DWORD) OPEN_EXISTING,
                 (DWORD) 0,
                 (HANDLE) NULL);
 
-        if (h == INVALID_HANDLE_VALUE)
+        if (pipe != INVALID_HANDLE_VALUE)
+            break;
+
+        if (::GetLastError() != ERROR_PIPE_BUSY
+            or  not ::WaitNamedPipe(m_pipeName, SERVE_TIMEOUT))
         {
-            STD::fprintf(stderr, "Can't read: %s\n", m_opt_fname);
+            STD::fprintf(stderr, "Can't connect: %s\n", m_pipeName);
             STD::fflush(stderr);
-            h = (HANDLE) NULL;
-            err = RC_READ;
+            pipe = (HANDLE) NULL;
+            err = RC_WRITE;
+            goto done;
+        }
+    }
+
+    mode = PIPE_READMODE_MESSAGE;
+    ::SetNamedPipeHandleState(pipe, &mode, NULL, NULL);
+
+    // Send the request and read the reply
+    if (not ::WriteFile(pipe, buf, len, &n, NULL)  or  n != len
+        or  not readMessage(pipe, &buf, &size, &len))
+    {
+        STD::fprintf(stderr, "Can't send request: %s\n", m_pipeName);
+        STD::fflush(stderr);
+        err = RC_WRITE;
+        goto done;
+    }
+
+    rh = (const ServeReply *) buf;
+    if (len < sizeof(*rh)  or  rh->magic != SERVE_MAGIC
+        or  rh->count != (DWORD) argc
+        or  len < sizeof(*rh) + argc*sizeof(ServeResult))
+    {
+        STD::fprintf(stderr, "Bad reply: %s\n", m_pipeName);
+        STD::fflush(stderr);
+        err = RC_READ;
+        goto done;
+    }
+
+    // Display the results
+    rr = (const ServeResult *) (buf + sizeof(*rh));
+    for (i = 0;  i < argc;  i++)
+    {
+        ChtimeResult	res;
+        int		rc;
+
+        res.fname = argv[i];
+        res.rc = rr[i].rc;
+        res.msg = rr[i].msg;
+        res.skipped = (rr[i].skipped != 0);
+        res.changed = (rr[i].changed != 0);
+        res.mtime = rr[i].mtime;
+        rc = showResult(&res);
+
+        if (err == RC_OKAY)
+            err = rc;
+    }
+
+done:
+    // Clean up
+    if (pipe != (HANDLE) NULL)
+        ::CloseHandle(pipe);
+    pipe = (HANDLE) NULL;
+    delete[] buf;
+
+    return err;
+}
+
+
+//------------------------------------------------------------------------------
+// Program::main()
+//
+// Param	argc
+//	The size of array 'argv'.
+//
+// Param	argv
+//	The command line argument strings.
+//
+// Returns
+//	'Program::RC_OKAY' (zero) on success, or one of the 'Program::RC_XXX'
+//	status codes on failure.
+//------------------------------------------------------------------------------
+
+int Program::main(int argc, const char *const *argv)
+{
+    ChtimeExecutor	exec(m_plan);
+    ChtimeDirCache *	cache =	NULL;
+    int			err =	RC_OKAY;
+    int			i;
+
+    // Parse command line options
+    i = parseOpts(argc, argv);
+    argc -= i;
+    argv += i;
+
+    // Check args
+    if (argc < 1  and  m_opt_serveName == NULL)
+        usage();
+    if (not m_plan.isValidDate())
+    {
+        STD::fprintf(stderr, "Bad date: day %d does not exist in month %d\n",
+            m_plan.m_mday, m_plan.m_mon);
+        STD::fflush(stderr);
+        usage();
+    }
+    if (m_opt_tar  and  (m_plan.m_create  or  m_opt_watch))
+        usage();
+    if ((m_opt_serveName != NULL  or  m_opt_clientName != NULL)
+        and  (m_opt_tar  or  m_opt_watch  or  m_opt_ckptName != NULL
+            or  m_opt_resumeName != NULL))
+        usage();
+    if ((m_opt_list  or  m_opt_histBucket != HB_NONE)
+        and  (m_plan.m_create  or  m_opt_tar  or  m_opt_watch
+            or  m_opt_serveName != NULL  or  m_opt_clientName != NULL))
+        usage();
+    if (m_opt_list  and  m_opt_histBucket != HB_NONE)
+        usage();
+    if ((m_plan.m_filters != 0  or  m_opt_olderSpec != NULL
+            or  m_opt_newerSpec != NULL)
+        and  (m_opt_watch  or  m_opt_serveName != NULL
+            or  m_opt_clientName != NULL))
+        usage();
+    if (m_opt_dirCache > 0  and  (m_opt_tar  or  m_opt_clientName != NULL))
+        usage();
+    if (m_opt_preserveDirs  and  (not m_plan.m_create
+            or  m_opt_serveName != NULL  or  m_opt_clientName != NULL))
+        usage();
+    if (m_opt_queueDepth > 0  and  (m_opt_tar
+            or  m_opt_serveName != NULL  or  m_opt_clientName != NULL))
+        usage();
+
+    if (m_opt_serveName != NULL  or  m_opt_clientName != NULL)
+    {
+        const char *	name;
+
+        // Qualify the pipe name
+        name = (m_opt_serveName != NULL ? m_opt_serveName : m_opt_clientName);
+        if (STD::strncmp(name, "\\\\", 2) == 0)
+            STD::sprintf(m_pipeName, "%.*s", MAX_PATH, name);
+        else
+            STD::sprintf(m_pipeName, "\\\\.\\pipe\\%.*s", MAX_PATH-9, name);
+    }
+
+    // Serve requests from clients
+    if (m_opt_serveName != NULL)
+    {
+        err = serve();
+        goto done;
+    }
+
+    m_ckpt_hash = hashArgs(argc, argv);
+    m_ckpt_tick = ::GetTickCount();
+    if (m_opt_ckptName != NULL)
+    {
+        m_ckpt_name = new char[CKPT_NAME_MAX+1];
+        m_ckpt_name[0] = '\0';
+    }
+
+    // Locate the resume cursor
+    if (m_opt_resumeName != NULL)
+    {
+        err = readCheckpoint(argc, argv);
+        if (err != RC_OKAY)
             goto done;
+    }
+
+    // Process options
+    m_plan.m_readBack = m_opt_verbose;
+
+    if (m_opt_clamp)
+    {
+        const char *	spec;
+        char		buf[40+1];
+        DWORD		n;
+        FILETIME	ft;
+
+        // Use the clamp time as the new timestamp
+        if (m_opt_fname != NULL
+            or  m_plan.m_year != -1  or  m_plan.m_mon != -1
+            or  m_plan.m_mday != -1)
+            usage();
+
+        spec = m_opt_clampSpec;
+        if (spec == NULL)
+        {
+            // Use the reproducible build time, in seconds since 1970
+            n = ::GetEnvironmentVariable("SOURCE_DATE_EPOCH", buf+1,
+                    sizeof(buf)-1);
+            if (n == 0  or  n >= sizeof(buf)-1)
+            {
+                STD::fprintf(stderr, "SOURCE_DATE_EPOCH is not set\n");
+                STD::fflush(stderr);
+                usage();
+            }
+            buf[0] = '@';
+            spec = buf;
+        }
+
+        if (not ChtimePlan::parseTime(spec, m_plan.m_localTime, &ft))
+        {
+            STD::fprintf(stderr, "Bad date specification: %s\n", spec);
+            STD::fflush(stderr);
+            usage();
         }
 
-        // Retrieve the model file's timestamp
-        if (not ::GetFileTime(h, (FILETIME *) NULL, (FILETIME *) NULL,
-                &m_opt_fname_tm))
+        m_plan.setClamp(&ft);
+    }
+    else if (m_opt_fname != NULL)
+    {
+        const char *	msg;
+
+        // Use the model file's timestamp
+        err = m_plan.setModel(m_opt_fname, &msg);
+        if (err != RC_OKAY)
         {
-            STD::fprintf(stderr, "Can't get timestamp for: %s\n", m_opt_fname);
+            STD::fprintf(stderr, "%s: %s\n", msg, m_opt_fname);
             STD::fflush(stderr);
-            err = RC_TIME;
             goto done;
         }
+    }
 
-        // Clean up
-        ::CloseHandle(h);
-        h = (HANDLE) NULL;
+    // Compile the filters
+    for (i = 0;  i < 2;  i++)
+    {
+        const char *	spec;
+        FILETIME	ft;
+
+        spec = (i == 0 ? m_opt_olderSpec : m_opt_newerSpec);
+        if (spec == NULL)
+            continue;
+
+        if (not ChtimePlan::parseTime(spec, m_plan.m_localTime, &ft))
+        {
+            STD::fprintf(stderr, "Bad date specification: %s\n", spec);
+            STD::fflush(stderr);
+            usage();
+        }
+
+        if (i == 0)
+            m_plan.setOlder(&ft);
+        else
+            m_plan.setNewer(&ft);
+    }
+
+    // Send the filenames to a server
+    if (m_opt_clientName != NULL)
+    {
+        err = requestFiles(argc, argv);
+        goto done;
+    }
+
+    // Open the files relative to their cached directories
+    if (m_opt_dirCache > 0)
+    {
+        cache = new ChtimeDirCache(m_opt_dirCache);
+        exec.setDirCache(cache);
+    }
+
+    // Record the timestamps of the directories before creating files
+    if (m_opt_preserveDirs)
+    {
+        m_times = new ChtimeDirTimes;
+        exec.setDirTimes(m_times);
+
+        // Restore them if the program is interrupted
+        s_dirTimes = m_times;
+        ::SetConsoleCtrlHandler(&ctrlHandler, TRUE);
     }
-    else if (m_opt_year == -1  and  m_opt_mon == -1  and  m_opt_mday == -1)
+
+    // Change several files at a time, using worker threads
+    if (m_opt_queueDepth > 1  and  not exec.setQueueDepth(m_opt_queueDepth))
     {
-        // Use the current date/time
-        m_opt_fname = "";
+        STD::fprintf(stderr,
+            "Can't start worker threads, changing one file at a time\n");
+        STD::fflush(stderr);
     }
 
+    // List the timestamps, or change the archive members, instead
+    if (m_opt_list  or  m_opt_histBucket != HB_NONE)
+        exec.setMode(ChtimeExecutor::MO_LIST);
+    if (m_opt_tar)
+        exec.setMode(ChtimeExecutor::MO_TAR);
+
     // Process filename args
-    for (i = 0;  i < argc;  i++)
+    m_exec = &exec;
+    for (i = m_resume_arg;  i < argc;  i++)
     {
         int	rc;
 
         // Change timestamps of several wildcarded filenames
-        rc = changeFiles(argv[i]);
+        m_ckpt_arg = i;
+        m_ckpt_match = 0;
+        if (m_ckpt_name != NULL)
+            m_ckpt_name[0] = '\0';
+        rc = exec.changePattern(argv[i], this,
+            i == m_resume_arg ? m_resume_match : 0,
+            i == m_resume_arg ? m_resume_name : NULL);
 
         if (err == RC_OKAY)
             err = rc;
     }
 
+    // Restore the timestamps of the directories of the created files
+    i = restoreDirTimes();
+    if (err == RC_OKAY)
+        err = i;
+
+    // Record the completion of all the filename args
+    m_ckpt_arg = argc;
+    m_ckpt_match = 0;
+    if (m_ckpt_name != NULL)
+        m_ckpt_name[0] = '\0';
+    if (writeCheckpoint(true) != RC_OKAY  and  err == RC_OKAY)
+        err = RC_WRITE;
+
+    // Display the histogram of the file timestamps
+    if (m_opt_histBucket != HB_NONE)
+        showHistogram();
+
+    // Continue to change new and written files
+    if (m_opt_watch)
+    {
+        i = watchFiles(argc, argv);
+        if (err == RC_OKAY)
+            err = i;
+    }
+
 done:
     // Done, clean up
-    if (h != (HANDLE) NULL)
-        ::CloseHandle(h);
-    h = (HANDLE) NULL;
+    m_exec = NULL;
+    delete cache;
+    cache = NULL;
+    if (m_times != NULL)
+    {
+        ::SetConsoleCtrlHandler(&ctrlHandler, FALSE);
+        s_dirTimes = NULL;
+    }
+    delete m_times;
+    m_times = NULL;
 
     // Done
     STD::exit(err);
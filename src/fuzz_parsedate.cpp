@@ -0,0 +1,240 @@
+//==============================================================================
+// fuzz_parsedate.cpp
+//	Fuzzing and property test driver for the date/time specification parser
+//	of the 'libchtime' library.
+//
+// Notes
+//	This program is written for Microsoft Win32 only.
+//
+//	Compiled with a fuzzing engine (e.g., 'clang-cl /fsanitize=fuzzer') and
+//	macro 'FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION' defined, the engine
+//	calls 'LLVMFuzzerTestOneInput()' with arbitrary inputs, and aborts on
+//	any parsed date that is out of range.
+//
+//	Otherwise, 'main()' checks that every day from 1900 through 2100
+//	survives a round trip through 'ChtimePlan::parseDate()', a file
+//	timestamp, and 'ChtimePlan::formatTime()', then displays the parsing
+//	throughput.  It exits with a nonzero status if any round trip fails.
+//
+// Copyright 2000-2010 by David R. Tribble, all rights reserved.
+//------------------------------------------------------------------------------
+
+
+// Identification
+
+static char		ID[] =
+    "@(#)drt/src/cmd/fuzz_parsedate.cpp $Revision: 1.1 $ $Date: 2026/10/18 12:00:00 $\n";
+
+
+// System includes
+
+#ifndef _WIN32
+ #error Compile this under Win32 only
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define WIN32_LEAN_AND_MEAN	1
+#include <windows.h>
+
+
+// Local includes
+
+#include "libchtime.h"
+
+
+// Local constants
+
+#define and		&&
+#define or		||
+#define not		!
+
+#if 0
+ #define STD		std
+#else
+ #define STD		/**/
+#endif
+
+#define PARSE_LOOPS	1000000		// Parses timed for the throughput
+
+
+//------------------------------------------------------------------------------
+// ::LLVMFuzzerTestOneInput()
+//	Fuzzing engine entry point, which parses an arbitrary input as a date/
+//	time specification.
+//
+// Param	data
+//	The input bytes, which are not null-terminated.
+//
+// Param	size
+//	The number of bytes in 'data'.
+//
+// Returns
+//	Zero.  The program is aborted if the input is accepted but parses into
+//	a date or time that is out of range.
+//------------------------------------------------------------------------------
+
+extern "C"
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size)
+{
+    char *	spec;
+    SYSTEMTIME	st;
+    FILETIME	ft;
+
+    // Make a null-terminated copy of the input
+    spec = new char[size+1];
+    STD::memcpy(spec, data, size);
+    spec[size] = '\0';
+
+    // Parse the input, and check any date it is accepted as
+    if (ChtimePlan::parseDate(spec, &st))
+    {
+        if (st.wYear < 1900  or  st.wYear > 2100
+            or  st.wMonth < 1  or  st.wMonth > 12
+            or  st.wDay < 1
+            or  st.wDay > ChtimePlan::daysInMonth(st.wYear, st.wMonth)
+            or  st.wHour > 23  or  st.wMinute > 59  or  st.wSecond > 59
+            or  st.wMilliseconds > 999
+            or  not ::SystemTimeToFileTime(&st, &ft))
+            STD::abort();
+    }
+
+    delete[] spec;
+    return 0;
+}
+
+
+#ifndef FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
+
+//------------------------------------------------------------------------------
+// ::checkRoundTrips()
+//	Check that every day from 1900 through 2100, each at a different time
+//	of day, is parsed, converted into a file timestamp, and formatted back
+//	into the same date and time.
+//
+// Returns
+//	The number of days that failed the round trip.
+//------------------------------------------------------------------------------
+
+static long checkRoundTrips()
+{
+    long	fails =	0;
+    int		year;
+    int		mon;
+    int		day;
+
+    for (year = 1900;  year <= 2100;  year++)
+    {
+        for (mon = 1;  mon <= 12;  mon++)
+        {
+            for (day = 1;  day <= ChtimePlan::daysInMonth(year, mon);  day++)
+            {
+                char		spec[40+1];
+                char		want[40+1];
+                char		got[ChtimePlan::TIME_LEN+1];
+                SYSTEMTIME	st;
+                FILETIME	ft;
+                int		hh;
+                int		mm;
+                int		ss;
+                int		ms;
+
+                // Build the specification, and the expected timestamp
+                hh = day % 24;
+                mm = (day*7 + mon) % 60;
+                ss = (year + day) % 60;
+                ms = (year*mon + day) % 1000;
+                STD::sprintf(spec, "%04d-%02d-%02d.%02d:%02d:%02d.%03d",
+                    year, mon, day, hh, mm, ss, ms);
+                STD::sprintf(want, "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+                    year, mon, day, hh, mm, ss, ms);
+
+                // Parse it, convert it, and format it again
+                got[0] = '\0';
+                if (not ChtimePlan::parseDate(spec, &st)
+                    or  not ::SystemTimeToFileTime(&st, &ft)
+                    or  not ChtimePlan::formatTime(&ft, false, got)
+                    or  STD::strcmp(got, want) != 0)
+                {
+                    STD::fprintf(stderr, "Round trip failed: %s -> %s\n",
+                        spec, got);
+                    STD::fflush(stderr);
+                    fails++;
+                }
+            }
+        }
+    }
+
+    return fails;
+}
+
+
+//------------------------------------------------------------------------------
+// ::timeParses()
+//	Display the throughput of parsing date/time specifications.
+//------------------------------------------------------------------------------
+
+static void timeParses()
+{
+    static const char *const	s_specs[] =
+    {
+        "2010-03-12",
+        "10-3-12.18:39",
+        "2010-03-12.18:39:14",
+        "2010-03-12.18:39:14.123",
+        "2009-02-29",
+        "2010-13-01.00:00"
+    };
+
+    LARGE_INTEGER	freq;
+    LARGE_INTEGER	t0;
+    LARGE_INTEGER	t1;
+    SYSTEMTIME		st;
+    long		ok =	0;
+    double		secs;
+    long		i;
+
+    // Parse a mix of valid and invalid specifications
+    ::QueryPerformanceFrequency(&freq);
+    ::QueryPerformanceCounter(&t0);
+    for (i = 0;  i < PARSE_LOOPS;  i++)
+    {
+        if (ChtimePlan::parseDate(s_specs[i % 6], &st))
+            ok++;
+    }
+    ::QueryPerformanceCounter(&t1);
+
+    // Display the throughput
+    secs = (double) (t1.QuadPart - t0.QuadPart) / (double) freq.QuadPart;
+    STD::fprintf(stdout, "parseDate: %ld parses (%ld valid) in %.3f sec, "
+        "%.1f nsec/parse\n", (long) PARSE_LOOPS, ok, secs,
+        secs*1.0e9/PARSE_LOOPS);
+    STD::fflush(stdout);
+}
+
+
+//------------------------------------------------------------------------------
+// ::main()
+//
+// Returns
+//	Zero if all of the round trips succeed, otherwise 1.
+//------------------------------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    long	fails;
+
+    // Check the round trips, then time the parser
+    fails = checkRoundTrips();
+    STD::fprintf(stdout, "Round trips: %ld failed\n", fails);
+    STD::fflush(stdout);
+
+    timeParses();
+    return (fails == 0 ? 0 : 1);
+}
+
+#endif // FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION
+
+// End fuzz_parsedate.cpp
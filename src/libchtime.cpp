@@ -0,0 +1,3125 @@
+//==============================================================================
+// libchtime.cpp
+//	In-process interface for changing the modification timestamps of files.
+//
+// Notes
+//	This library is written for Microsoft Win32 only.
+//
+//	Compile with macro 'DEBUGS' defined to a nonzero value to enable
+//	debugging output.
+//
+// Copyright 2000-2010 by David R. Tribble, all rights reserved.
+//------------------------------------------------------------------------------
+
+
+// Identification
+
+static char		ID[] =
+    "@(#)drt/src/cmd/libchtime.cpp $Revision: 1.1 $ $Date: 2026/10/18 12:00:00 $\n";
+
+#ifdef DEBUGS
+ #undef  DEBUGS
+ #define DEBUGS		1
+#else
+ #define DEBUGS		0
+#endif
+
+
+// System includes
+
+#ifndef _WIN32
+ #error Compile this under Win32 only
+#endif
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define WIN32_LEAN_AND_MEAN	1
+#include <windows.h>
+#include <winternl.h>
+
+
+// Local includes
+
+#include "libchtime.h"
+
+
+// Local constants
+
+#define and		&&
+#define or		||
+#define not		!
+
+#if 0
+ #define STD		std
+#else
+ #define STD		/**/
+#endif
+
+#ifndef NT_SUCCESS
+ #define NT_SUCCESS(s)	((NTSTATUS) (s) >= 0)
+#endif
+
+
+// Local types
+
+typedef NTSTATUS (NTAPI *NtCreateFileFunc)(PHANDLE h, ACCESS_MASK access,
+    POBJECT_ATTRIBUTES attrs, PIO_STATUS_BLOCK iosb, PLARGE_INTEGER alloc,
+    ULONG fattrs, ULONG share, ULONG disp, ULONG opts, PVOID ea, ULONG ealen);
+				// NtCreateFile(), exported by NTDLL
+
+
+// Local variables
+
+static NtCreateFileFunc	s_ntCreateFile =	NULL;
+				// NtCreateFile(), or null if not found
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::ChtimePlan()
+//	Default constructor.
+//
+//	Unless a model timestamp or any of the year, month, or day fields are
+//	set, the plan changes the timestamps to the current date and time.
+//------------------------------------------------------------------------------
+
+/*void*/ ChtimePlan::ChtimePlan():
+    m_create(false),
+    m_localTime(true),
+    m_readBack(false),
+    m_year(-1),
+    m_mon(-1),
+    m_mday(-1),
+    m_hour(-1),
+    m_min(-1),
+    m_sec(-1),
+    m_msec(-1),
+    m_useTime(false),
+    m_time(),
+    m_clamp(false),
+    m_clampTime(),
+    m_shardIdx(0),
+    m_shardCnt(0),
+    m_filters(0),
+    m_olderTime(),
+    m_newerTime(),
+    m_minSize(0),
+    m_maxSize(0),
+    m_typeDir(false),
+    m_excludeCnt(0)
+{
+#if ChtimePlan_VS != 130
+ #error Class ChtimePlan has changed
+#endif
+
+    // Initialize
+    ::GetSystemTimeAsFileTime(&m_time);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::~ChtimePlan()
+//	Destructor.
+//------------------------------------------------------------------------------
+
+/*void*/ ChtimePlan::~ChtimePlan()
+{
+#if ChtimePlan_VS != 130
+ #error Class ChtimePlan has changed
+#endif
+
+    // Nothing to do
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::parseDate()
+//	Parse a date/time specification.
+//
+// Param	date
+//	A date/time specification of the form:
+//	    "[CC]YY-MM-DD[.hh:mm[:ss[.uuu]]]"
+//	The day must exist within the month and year, so that an impossible
+//	date is rejected here rather than when each file is changed.
+//
+// Param	st
+//	Pointer to a system time structure, which is filled in with the parsed
+//	values of string 'date'.
+//
+// Returns
+//	True if the date/time specification 'date' is correctly formed,
+//	otherwise false.
+//------------------------------------------------------------------------------
+
+/*static*/
+bool ChtimePlan::parseDate(const char *date, SYSTEMTIME *st)
+{
+    const char *	s;
+    int			v;
+
+    // Initialize
+    STD::memset(st, 0, sizeof(*st));
+
+    // Extract the '[CC]YY' (year) portion
+    s = date;
+    if (not parseDigits(&s, 2, 4, &v)  or  *s == '\0')
+        return false;
+    if (v < 100)
+        v += 2000;
+    if (v < 1900  or  v > 2100)
+        return false;
+    st->wYear = v;
+
+    // Extract the 'MM' (month) portion
+    s++;
+    if (not parseDigits(&s, 1, 2, &v)  or  *s == '\0')
+        return false;
+    if (v < 1  or  v > 12)
+        return false;
+    st->wMonth = v;
+
+    // Extract the 'DD' (day) portion
+    s++;
+    if (not parseDigits(&s, 1, 2, &v))
+        return false;
+    if (v < 1  or  v > daysInMonth(st->wYear, st->wMonth))
+        return false;
+    st->wDay = v;
+
+    if (*s == '\0')
+        return true;
+
+    // Extract the 'hh' (hour) portion
+    s++;
+    if (not parseDigits(&s, 1, 2, &v)  or  *s == '\0')
+        return false;
+    if (v > 23)
+        return false;
+    st->wHour = v;
+
+    // Extract the 'mm' (minute) portion
+    s++;
+    if (not parseDigits(&s, 1, 2, &v))
+        return false;
+    if (v > 59)
+        return false;
+    st->wMinute = v;
+
+    if (*s == '\0')
+        return true;
+
+    // Extract the 'ss' (second) portion
+    s++;
+    if (not parseDigits(&s, 1, 2, &v))
+        return false;
+    if (v > 59)
+        return false;
+    st->wSecond = v;
+
+    if (*s == '\0')
+        return true;
+
+    // Extract the 'uuu' (millisecond) portion
+    s++;
+    if (not parseDigits(&s, 1, 3, &v))
+        return false;
+    st->wMilliseconds = v;
+
+    if (*s != '\0')
+        return false;
+
+    // Success
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::parseDigits()
+//	Parse a field of decimal digits within a date/time specification.
+//
+// Param	s
+//	Pointer to the position of the field within the specification, which is
+//	advanced past the digits on success.
+//
+// Param	min
+//	The minimum number of digits in the field.
+//
+// Param	max
+//	The maximum number of digits in the field, which is small enough that
+//	the value can't overflow.
+//
+// Param	v
+//	Pointer to a number, which is filled in with the value of the field.
+//
+// Returns
+//	True if the field contains from 'min' to 'max' digits, otherwise false.
+//------------------------------------------------------------------------------
+
+/*static*/
+bool ChtimePlan::parseDigits(const char **s, int min, int max, int *v)
+{
+    const char *	p;
+
+    // Accumulate the digits, rejecting too many of them
+    *v = 0;
+    for (p = *s;  STD::isdigit((unsigned char) *p);  p++)
+    {
+        if (p - *s >= max)
+            return false;
+        *v = *v*10 + (*p - '0');
+    }
+
+    if (p - *s < min)
+        return false;
+
+    *s = p;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::formatTime()
+//	Format a file timestamp, in the form:
+//	    "CCYY-MM-DD hh:mm:ss.uuu"
+//
+// Param	ft
+//	A file timestamp (UTC).
+//
+// Param	localTime
+//	True if the timestamp is to be formatted in local time, false if it is
+//	to be formatted as UTC.
+//
+// Param	buf
+//	A buffer of at least 'TIME_LEN'+1 characters, which is filled in with
+//	the formatted timestamp.
+//
+// Returns
+//	True on success, or false if the timestamp can't be converted.
+//------------------------------------------------------------------------------
+
+/*static*/
+bool ChtimePlan::formatTime(const FILETIME *ft, bool localTime, char *buf)
+{
+    FILETIME	lt;
+    SYSTEMTIME	mt;
+
+    // Convert the timestamp into a broken-down form
+    lt = *ft;
+    if (localTime  and  not ::FileTimeToLocalFileTime(ft, &lt))
+        return false;
+    if (not ::FileTimeToSystemTime(&lt, &mt))
+        return false;
+
+    // Format the timestamp
+    STD::sprintf(buf, "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+        mt.wYear,
+        mt.wMonth,
+        mt.wDay,
+        mt.wHour,
+        mt.wMinute,
+        mt.wSecond,
+        mt.wMilliseconds);
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::daysInMonth()
+//	Determine the number of days in a month of the Gregorian calendar.
+//
+// Param	year
+//	The year number (e.g., 2010), or -1 if the year is not known, in which
+//	case February is taken to have 29 days.
+//
+// Param	mon
+//	The month number, 1 to 12.
+//
+// Returns
+//	The number of days in month 'mon' of year 'year', or zero if 'mon' is
+//	not a valid month number.
+//------------------------------------------------------------------------------
+
+/*static*/
+int ChtimePlan::daysInMonth(int year, int mon)
+{
+    static const int	s_days[12] =
+        { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+    if (mon < 1  or  mon > 12)
+        return 0;
+
+    // February has an extra day in leap years
+    if (mon == 2
+        and  (year == -1
+            or  (year%4 == 0  and  (year%100 != 0  or  year%400 == 0))))
+        return 29;
+
+    return s_days[mon-1];
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::parseTime()
+//	Parse a timestamp specification.
+//
+// Param	spec
+//	A timestamp specification, which is either a date/time specification
+//	of the form accepted by 'parseDate()', or a string of the form "@SECS",
+//	specifying a number of seconds since 1970-01-01 00:00:00 UTC.
+//
+// Param	localTime
+//	True if a date/time specification is in local time, false if it is in
+//	UTC.
+//
+// Param	ft
+//	Pointer to a file timestamp, which is filled in with the parsed value
+//	of 'spec' (as UTC).
+//
+// Returns
+//	True if the timestamp specification 'spec' is correctly formed,
+//	otherwise false.
+//------------------------------------------------------------------------------
+
+/*static*/
+bool ChtimePlan::parseTime(const char *spec, bool localTime, FILETIME *ft)
+{
+    SYSTEMTIME		st;
+    ULARGE_INTEGER	t;
+
+    // Parse a time in seconds since 1970
+    if (spec[0] == '@')
+    {
+        const char *	s;
+
+        // Convert seconds since 1970-01-01
+        t.QuadPart = 0;
+        for (s = &spec[1];  STD::isdigit((unsigned char) *s)  and  s - spec <= 12;
+            s++)
+            t.QuadPart = t.QuadPart*10 + (*s - '0');
+        if (s == &spec[1]  or  *s != '\0')
+            return false;
+
+        toFileTime(t.QuadPart, 0, ft);
+        return true;
+    }
+
+    // Convert a date/time specification
+    if (not parseDate(spec, &st))
+        return false;
+    if (not ::SystemTimeToFileTime(&st, ft))
+        return false;
+    if (localTime  and  not ::LocalFileTimeToFileTime(ft, ft))
+        return false;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::toFileTime()
+//	Convert a time since 1970-01-01 00:00:00 UTC into a file timestamp.
+//
+// Param	secs
+//	Number of seconds since 1970-01-01 00:00:00 UTC.
+//
+// Param	ticks
+//	Additional number of 100-nanosecond ticks, less than 10,000,000.
+//
+// Param	ft
+//	Pointer to a file timestamp, which is filled in with the converted
+//	time.
+//------------------------------------------------------------------------------
+
+/*static*/
+void ChtimePlan::toFileTime(ULONGLONG secs, DWORD ticks, FILETIME *ft)
+{
+    ULARGE_INTEGER	t;
+
+    // Convert seconds since 1970 into 100-nsec ticks since 1601
+    t.QuadPart = (secs + 11644473600) * 10000000 + ticks;
+    ft->dwLowDateTime =  t.LowPart;
+    ft->dwHighDateTime = t.HighPart;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::fromFileTime()
+//	Convert a file timestamp into a time since 1970-01-01 00:00:00 UTC.
+//	Timestamps prior to 1970 are converted as 1970-01-01 00:00:00.
+//
+// Param	ft
+//	A file timestamp.
+//
+// Param	secs
+//	Pointer to a number of seconds, which is filled in with the number of
+//	whole seconds of 'ft' since 1970-01-01 00:00:00 UTC.
+//
+// Param	ticks
+//	Pointer to a number of ticks, which is filled in with the remaining
+//	number of 100-nanosecond ticks of 'ft'.
+//------------------------------------------------------------------------------
+
+/*static*/
+void ChtimePlan::fromFileTime(const FILETIME *ft, ULONGLONG *secs, DWORD *ticks)
+{
+    ULARGE_INTEGER	t;
+
+    t.LowPart =  ft->dwLowDateTime;
+    t.HighPart = ft->dwHighDateTime;
+    if (t.QuadPart < (ULONGLONG) 11644473600 * 10000000)
+        t.QuadPart = (ULONGLONG) 11644473600 * 10000000;
+
+    *secs = t.QuadPart/10000000 - 11644473600;
+    *ticks = (DWORD) (t.QuadPart%10000000);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::hashPath()
+//	Compute a stable hash of a filename path.
+//
+//	The hash is the 32-bit FNV-1a hash of the path, ignoring case and
+//	treating '/' and '\' as the same character, so that every run computes
+//	the same value for the same file regardless of how it was named.
+//
+// Param	fname
+//	A filename path.
+//
+// Returns
+//	The hash value of 'fname'.
+//------------------------------------------------------------------------------
+
+/*static*/
+unsigned long ChtimePlan::hashPath(const char *fname)
+{
+    unsigned long	h =	2166136261UL;
+
+    for ( ;  *fname != '\0';  fname++)
+    {
+        int	ch;
+
+        ch = (unsigned char) *fname;
+        if (ch == '/')
+            ch = '\\';
+        h = ((h ^ STD::tolower(ch)) * 16777619UL) & 0xFFFFFFFFUL;
+    }
+
+    return h;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::splitPath()
+//	Extract the directory path prefix of a filename pattern, which is the
+//	part of the pattern up to and including its last '\', '/', or drive ':'
+//	(e.g., "C:" for "C:*.txt"), with each '/' replaced by '\'.
+//
+//	Every file found by searching for the pattern is named by appending its
+//	name to the prefix, so all callers must split patterns the same way for
+//	the names (and their shard hashes) to agree.
+//
+// Param	pat
+//	A filename pattern.
+//
+// Param	dir
+//	A buffer of at least 'max'+1 characters, which is filled in with the
+//	null-terminated directory prefix of 'pat', possibly empty.
+//
+// Param	max
+//	The maximum length of 'pat'.
+//
+// Returns
+//	The length of the directory prefix, or -1 if 'pat' is longer than 'max'
+//	characters.
+//------------------------------------------------------------------------------
+
+/*static*/
+int ChtimePlan::splitPath(const char *pat, char *dir, int max)
+{
+    int		len =	0;
+    int		i;
+
+    for (i = 0;  pat[i] != '\0';  i++)
+    {
+        if (i >= max)
+        {
+            dir[0] = '\0';
+            return -1;
+        }
+
+        dir[i] = (pat[i] == '/' ? '\\' : pat[i]);
+        if (dir[i] == '\\'  or  dir[i] == ':')
+            len = i+1;
+    }
+
+    dir[len] = '\0';
+    return len;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::parseSize()
+//	Parse a file size specification, of the form:
+//	    "N[K|M|G|T]"
+//	where the optional suffix multiplies 'N' by a power of 1024.
+//
+// Param	spec
+//	A file size specification.
+//
+// Param	size
+//	Pointer to a file size, which is filled in with the parsed size.
+//
+// Returns
+//	True if 'spec' is a valid size specification, otherwise false.
+//------------------------------------------------------------------------------
+
+/*static*/
+bool ChtimePlan::parseSize(const char *spec, ULONGLONG *size)
+{
+    const char *	s;
+    ULONGLONG		n;
+    int			shift;
+
+    // Convert the number
+    n = 0;
+    for (s = spec;  STD::isdigit((unsigned char) *s)  and  s - spec < 15;  s++)
+        n = n*10 + (*s - '0');
+    if (s == spec)
+        return false;
+
+    // Convert the multiplier suffix
+    shift = 0;
+    if (*s != '\0')
+    {
+        switch (STD::toupper((unsigned char) *s))
+        {
+        case 'K':	shift = 10;	break;
+        case 'M':	shift = 20;	break;
+        case 'G':	shift = 30;	break;
+        case 'T':	shift = 40;	break;
+        default:	return false;
+        }
+
+        if (*++s != '\0')
+            return false;
+    }
+
+    if (n > (~(ULONGLONG) 0 >> shift))
+        return false;
+
+    *size = n << shift;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::matchName()
+//	Match a filename against a wildcarded filename pattern, ignoring case.
+//
+// Param	pat
+//	Filename pattern, which may contain wildcard characters ('?' and '*').
+//
+// Param	name
+//	A filename, without a directory path prefix.
+//
+// Returns
+//	True if 'name' matches 'pat', otherwise false.
+//------------------------------------------------------------------------------
+
+/*static*/
+bool ChtimePlan::matchName(const char *pat, const char *name)
+{
+    const char *	star =	NULL;
+    const char *	back =	NULL;
+
+    while (*name != '\0')
+    {
+        if (*pat == '*')
+        {
+            // Match zero characters for now, retry with more later
+            star = ++pat;
+            back = name;
+        }
+        else if (*pat == '?'
+            or  STD::tolower((unsigned char) *pat) ==
+                STD::tolower((unsigned char) *name))
+        {
+            // Match a single character
+            pat++;
+            name++;
+        }
+        else if (star != NULL)
+        {
+            // Let the last '*' match one more character
+            pat = star;
+            name = ++back;
+        }
+        else
+            return false;
+    }
+
+    while (*pat == '*')
+        pat++;
+    return (*pat == '\0');
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::setModel()
+//	Change the timestamps to the modification time of a model file.
+//
+// Param	fname
+//	The name of the model file.
+//
+// Param	msg
+//	Pointer to a message, which is set to describe the failure on failure.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, or one of the
+//	'ChtimePlan::RC_XXX' status codes on failure.
+//------------------------------------------------------------------------------
+
+int ChtimePlan::setModel(const char *fname, const char **msg)
+{
+    HANDLE	h;
+    int		err =	RC_OKAY;
+
+    // Open the existing model file
+    h = ::CreateFile(
+            (LPCSTR) fname,
+            (DWORD) GENERIC_READ,
+            (DWORD) FILE_SHARE_READ,
+            (LPSECURITY_ATTRIBUTES) NULL,
+            (DWORD) OPEN_EXISTING,
+            (DWORD) 0,
+            (HANDLE) NULL);
+
+    if (h == INVALID_HANDLE_VALUE)
+    {
+        *msg = "Can't read";
+        return RC_READ;
+    }
+
+    // Retrieve the model file's timestamp
+    if (not ::GetFileTime(h, (FILETIME *) NULL, (FILETIME *) NULL, &m_time))
+    {
+        *msg = "Can't get timestamp for";
+        err = RC_TIME;
+    }
+    else
+        m_useTime = true;
+
+    // Clean up
+    ::CloseHandle(h);
+    h = (HANDLE) NULL;
+
+    return err;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::setClamp()
+//	Change only the timestamps later than a given time, to that time.
+//
+// Param	ft
+//	The clamp timestamp (UTC).
+//------------------------------------------------------------------------------
+
+void ChtimePlan::setClamp(const FILETIME *ft)
+{
+    m_clamp = true;
+    m_clampTime = *ft;
+    m_useTime = true;
+    m_time = *ft;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::inShard()
+//	Determine whether a filename belongs to the shard of this plan.
+//
+//	The shard is determined by the hash of the filename relative to the
+//	directory of its pattern.  For an absolute path (with a drive, UNC, or
+//	root prefix), this is only the name after its last '\', '/', or ':', so
+//	that the same file reached through different mounts of a share (e.g.,
+//	"Z:\" and "\\srv\share") belongs to the same shard.  A relative path
+//	is hashed as a whole, subdirectories included.
+//
+// Param	fname
+//	The name of a file.
+//
+// Returns
+//	True if 'fname' is to be changed by this plan, otherwise false.
+//------------------------------------------------------------------------------
+
+bool ChtimePlan::inShard(const char *fname) const
+{
+    const char *	p;
+
+    if (m_shardCnt <= 1)
+        return true;
+
+    // Hash only the name of a file with an absolute path
+    if (fname[0] == '\\'  or  fname[0] == '/'
+        or  (fname[0] != '\0'  and  fname[1] == ':'))
+    {
+        for (p = fname;  *p != '\0';  p++)
+        {
+            if (*p == '\\'  or  *p == '/'  or  *p == ':')
+                fname = p+1;
+        }
+    }
+
+    return (hashPath(fname) % m_shardCnt == m_shardIdx);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::isClamped()
+//	Determine whether a file timestamp is already within the clamp time.
+//
+// Param	mtime
+//	The modification timestamp of a file.
+//
+// Returns
+//	True if clamping is in effect and 'mtime' is not later than
+//	the clamp time, i.e., the file does not need to be changed, otherwise
+//	false.
+//------------------------------------------------------------------------------
+
+bool ChtimePlan::isClamped(const FILETIME *mtime) const
+{
+    if (not m_clamp)
+        return false;
+
+    return (::CompareFileTime(mtime, &m_clampTime) <= 0);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::isValidDate()
+//	Determine whether the year, month, and day fields to be changed are
+//	valid, and whether they can form a real date.
+//
+//	Fields that are not changed are taken from each file's timestamp, so a
+//	day that exists only in some months (e.g., the 31st, with no month
+//	specified) is accepted.
+//
+// Returns
+//	True if the changed date fields are valid, otherwise false.
+//------------------------------------------------------------------------------
+
+bool ChtimePlan::isValidDate() const
+{
+    if (m_year != -1  and  (m_year < 1900  or  m_year > 2100))
+        return false;
+    if (m_mon != -1  and  (m_mon < 1  or  m_mon > 12))
+        return false;
+    if (m_mday != -1  and  (m_mday < 1  or  m_mday > 31))
+        return false;
+
+    // Check the day against the month, if both are specified
+    if (m_mon != -1  and  m_mday != -1
+        and  m_mday > daysInMonth(m_year, m_mon))
+        return false;
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::setOlder()
+//	Select only the files last modified before a given time.
+//
+// Param	ft
+//	The timestamp (UTC).
+//------------------------------------------------------------------------------
+
+void ChtimePlan::setOlder(const FILETIME *ft)
+{
+    m_filters |= FI_OLDER;
+    m_olderTime = *ft;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::setNewer()
+//	Select only the files last modified after a given time.
+//
+// Param	ft
+//	The timestamp (UTC).
+//------------------------------------------------------------------------------
+
+void ChtimePlan::setNewer(const FILETIME *ft)
+{
+    m_filters |= FI_NEWER;
+    m_newerTime = *ft;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::setSize()
+//	Select only the files within a given size range.
+//
+// Param	min
+//	The minimum file size, in bytes.
+//
+// Param	max
+//	The maximum file size, in bytes.
+//------------------------------------------------------------------------------
+
+void ChtimePlan::setSize(ULONGLONG min, ULONGLONG max)
+{
+    m_filters |= FI_SIZE;
+    m_minSize = min;
+    m_maxSize = max;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::setType()
+//	Select only the files, or only the directories.
+//
+// Param	dir
+//	True to select only directories, or false to select only files.
+//------------------------------------------------------------------------------
+
+void ChtimePlan::setType(bool dir)
+{
+    m_filters |= FI_TYPE;
+    m_typeDir = dir;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::addExclude()
+//	Reject the files whose names match a wildcarded filename pattern.
+//
+// Param	pat
+//	Filename pattern, which may contain wildcard characters ('?' and '*').
+//	The pattern string is not copied, and must remain valid while this
+//	plan is in use.
+//
+// Returns
+//	True on success, or false if there are too many patterns.
+//------------------------------------------------------------------------------
+
+bool ChtimePlan::addExclude(const char *pat)
+{
+    if (m_excludeCnt >= EXCLUDE_MAX)
+        return false;
+
+    m_filters |= FI_EXCLUDE;
+    m_exclude[m_excludeCnt++] = pat;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::isSelected()
+//	Determine whether a file is selected by the filters of this plan.
+//
+//	Only the file information returned by the filename search is examined,
+//	so a file can be rejected without being opened.  Only the filters that
+//	have been set are tested.
+//
+// Param	fs
+//	The file information found by a filename search.
+//
+// Returns
+//	True if the file passes all of the filters, otherwise false.
+//------------------------------------------------------------------------------
+
+bool ChtimePlan::isSelected(const WIN32_FIND_DATA *fs) const
+{
+    if (m_filters == 0)
+        return true;
+
+    // Check the modification timestamp
+    if ((m_filters & FI_OLDER) != 0
+        and  ::CompareFileTime(&fs->ftLastWriteTime, &m_olderTime) >= 0)
+        return false;
+    if ((m_filters & FI_NEWER) != 0
+        and  ::CompareFileTime(&fs->ftLastWriteTime, &m_newerTime) <= 0)
+        return false;
+
+    // Check the file type
+    if ((m_filters & FI_TYPE) != 0
+        and  ((fs->dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+            != m_typeDir)
+        return false;
+
+    // Check the file size
+    if ((m_filters & FI_SIZE) != 0)
+    {
+        ULARGE_INTEGER	size;
+
+        size.LowPart =  fs->nFileSizeLow;
+        size.HighPart = fs->nFileSizeHigh;
+        if (size.QuadPart < m_minSize  or  size.QuadPart > m_maxSize)
+            return false;
+    }
+
+    // Check the excluded filename patterns
+    if ((m_filters & FI_EXCLUDE) != 0)
+    {
+        for (int i = 0;  i < m_excludeCnt;  i++)
+        {
+            if (matchName(m_exclude[i], (const char *) fs->cFileName))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimePlan::newTime()
+//	Determine the new timestamp of a file from its current timestamp, as
+//	specified by this plan.
+//
+// Param	mtime
+//	Pointer to the current modification timestamp (UTC) of the file, which
+//	is replaced with the new modification timestamp (UTC) of the file.
+//
+// Param	msg
+//	Pointer to a message, which is set to describe the failure on failure.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, or one of the
+//	'ChtimePlan::RC_XXX' status codes on failure.
+//------------------------------------------------------------------------------
+
+int ChtimePlan::newTime(FILETIME *mtime, const char **msg) const
+{
+    FILETIME	lt;
+    SYSTEMTIME	mt;
+
+#if DEBUGS
+    ::FileTimeToSystemTime(mtime, &mt);
+    STD::printf("$ stamp: %04d-%02d-%02d %02d:%02d:%02d.%03d Z\n",
+        mt.wYear, mt.wMonth, mt.wDay,
+        mt.wHour, mt.wMinute, mt.wSecond, mt.wMilliseconds);
+#endif
+
+    // Convert the timestamp into a broken-down form
+    lt = *mtime;
+    if (m_localTime)
+    {
+        if (not ::FileTimeToLocalFileTime(mtime, &lt))
+        {
+            *msg = "Can't get local timestamp for";
+            return RC_TIME;
+        }
+    }
+
+    if (not ::FileTimeToSystemTime(&lt, &mt))
+    {
+        *msg = "Can't convert timestamp for";
+        return RC_TIME;
+    }
+
+#if DEBUGS
+    STD::printf("$ stamp: %04d-%02d-%02d %02d:%02d:%02d.%03d LOC\n",
+        mt.wYear, mt.wMonth, mt.wDay,
+        mt.wHour, mt.wMinute, mt.wSecond, mt.wMilliseconds);
+#endif
+
+    // Set the file's timestamp
+    if (m_useTime  or  (m_year == -1  and  m_mon == -1  and  m_mday == -1))
+    {
+        // Set the file's timestamp to the model file's (or the current) time
+        *mtime = m_time;
+    }
+    else
+    {
+        // Change the file's timestamp
+        if (m_year != -1)
+            mt.wYear = m_year;
+        if (m_mon != -1)
+            mt.wMonth = m_mon;
+        if (m_mday != -1)
+            mt.wDay = m_mday;
+        if (m_hour != -1)
+            mt.wHour = m_hour;
+        if (m_min != -1)
+            mt.wMinute = m_min;
+        if (m_sec != -1)
+            mt.wSecond = m_sec;
+        if (m_msec != -1)
+            mt.wMilliseconds = m_msec;
+
+#if DEBUGS
+        STD::printf("$ stamp: %04d-%02d-%02d %02d:%02d:%02d.%03d NEW\n",
+            mt.wYear, mt.wMonth, mt.wDay,
+            mt.wHour, mt.wMinute, mt.wSecond, mt.wMilliseconds);
+#endif
+
+        // Convert the broken-down timestamp into a filestamp
+        if (not ::SystemTimeToFileTime(&mt, mtime))
+        {
+            *msg = "Can't convert file timestamp for";
+            return RC_TIME;
+        }
+
+        if (m_localTime)
+        {
+            if (not ::LocalFileTimeToFileTime(mtime, mtime))
+            {
+                *msg = "Can't convert local timestamp for";
+                return RC_TIME;
+            }
+        }
+    }
+
+
+    return RC_OKAY;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirCache::ChtimeDirCache()
+//	Constructor.
+//
+// Param	size
+//	The maximum number of directory handles to keep open, which is limited
+//	to 'DIR_CACHE_MAX'.  If this is zero, or if the native file open
+//	function is not available, no files are opened by the cache.
+//------------------------------------------------------------------------------
+
+/*void*/ ChtimeDirCache::ChtimeDirCache(int size):
+    m_ents(NULL),
+    m_size(0),
+    m_clock(0)
+{
+#if ChtimeDirCache_VS != 110
+ #error Class ChtimeDirCache has changed
+#endif
+
+    // Locate the native file open function, which can open a file relative
+    // to a directory handle
+    if (s_ntCreateFile == NULL)
+    {
+        HMODULE		lib;
+
+        lib = ::GetModuleHandle("ntdll.dll");
+        if (lib != NULL)
+            s_ntCreateFile =
+                (NtCreateFileFunc) ::GetProcAddress(lib, "NtCreateFile");
+    }
+
+    // Allocate the (empty) cache entries
+    if (size > DIR_CACHE_MAX)
+        size = DIR_CACHE_MAX;
+    if (size < 1)
+        return;
+
+    m_ents = new Entry[size];
+    m_size = size;
+
+    for (int i = 0;  i < m_size;  i++)
+    {
+        m_ents[i].dir = (HANDLE) NULL;
+        m_ents[i].hash = 0;
+        m_ents[i].used = 0;
+        m_ents[i].path[0] = '\0';
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirCache::~ChtimeDirCache()
+//	Destructor.
+//------------------------------------------------------------------------------
+
+/*void*/ ChtimeDirCache::~ChtimeDirCache()
+{
+#if ChtimeDirCache_VS != 110
+ #error Class ChtimeDirCache has changed
+#endif
+
+    // Close the cached directories
+    clear();
+
+    delete[] m_ents;
+    m_ents = NULL;
+    m_size = 0;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirCache::getSize()
+//	Retrieve the number of directories held by the cache.
+//
+// Returns
+//	The size of the cache, or zero if no directories are cached.
+//------------------------------------------------------------------------------
+
+int ChtimeDirCache::getSize() const
+{
+    return m_size;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirCache::clear()
+//	Close all of the cached directory handles.
+//------------------------------------------------------------------------------
+
+void ChtimeDirCache::clear()
+{
+    for (int i = 0;  i < m_size;  i++)
+    {
+        if (m_ents[i].dir != NULL)
+            ::CloseHandle(m_ents[i].dir);
+
+        m_ents[i].dir = (HANDLE) NULL;
+        m_ents[i].used = 0;
+        m_ents[i].path[0] = '\0';
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirCache::openDir()
+//	Retrieve the cached handle of a directory, opening the directory and
+//	replacing the least recently used directory if it is not cached.
+//
+// Param	path
+//	The directory path prefix, ending with a '\' separator.
+//
+// Returns
+//	The directory handle, or null if the directory can't be opened.
+//------------------------------------------------------------------------------
+
+HANDLE ChtimeDirCache::openDir(const char *path)
+{
+    unsigned long	hash;
+    Entry *		e;
+    HANDLE		h;
+    int			lru;
+    int			i;
+
+    // Look for the directory in the cache
+    hash = ChtimePlan::hashPath(path);
+    lru = 0;
+
+    for (i = 0;  i < m_size;  i++)
+    {
+        e = &m_ents[i];
+        if (e->dir != NULL  and  e->hash == hash
+            and  STD::strcmp(e->path, path) == 0)
+        {
+            e->used = ++m_clock;
+            return e->dir;
+        }
+
+        // Remember the least recently used (or an empty) entry
+        if (e->used < m_ents[lru].used)
+            lru = i;
+    }
+
+    // Replace the least recently used directory
+    e = &m_ents[lru];
+    if (e->dir != NULL)
+        ::CloseHandle(e->dir);
+    e->dir = (HANDLE) NULL;
+    e->used = 0;
+
+    h = ::CreateFile(
+            (LPCSTR) path,
+            (DWORD) FILE_TRAVERSE | SYNCHRONIZE,
+            (DWORD) FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            (LPSECURITY_ATTRIBUTES) NULL,
+            (DWORD) OPEN_EXISTING,
+            (DWORD) FILE_FLAG_BACKUP_SEMANTICS,	// Required for a directory
+            (HANDLE) NULL);
+
+    if (h == INVALID_HANDLE_VALUE)
+        return (HANDLE) NULL;
+
+    e->dir = h;
+    e->hash = hash;
+    e->used = ++m_clock;
+    STD::strcpy(e->path, path);
+    return h;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirCache::openFile()
+//	Open an existing file for writing, relative to the cached handle of its
+//	directory, with the same access and sharing as 'ChtimeExecutor' uses
+//	when opening a file by its full name.
+//
+//	Filenames without a directory path prefix, and names that the system
+//	would otherwise treat specially (streams, and names ending with '.' or
+//	' '), are not opened by the cache.
+//
+// Param	fname
+//	The name of a file.
+//
+// Returns
+//	A handle to the open file, or 'INVALID_HANDLE_VALUE' if the file can't
+//	be opened this way, in which case the caller should open it by its full
+//	name instead.
+//------------------------------------------------------------------------------
+
+HANDLE ChtimeDirCache::openFile(const char *fname)
+{
+    char		path[MAX_PATH+1];
+    WCHAR		wname[MAX_PATH+1];
+    const char *	name;
+    HANDLE		dir;
+    HANDLE		h;
+    int			len;
+    int			i;
+    UNICODE_STRING	us;
+    OBJECT_ATTRIBUTES	oa;
+    IO_STATUS_BLOCK	iosb;
+    NTSTATUS		st;
+
+    if (m_size == 0  or  s_ntCreateFile == NULL)
+        return INVALID_HANDLE_VALUE;
+
+    // Split the filename into its directory path prefix and its name
+    name = NULL;
+    for (i = 0;  fname[i] != '\0';  i++)
+    {
+        if (fname[i] == '\\'  or  fname[i] == '/')
+            name = &fname[i+1];
+    }
+
+    if (name == NULL  or  *name == '\0'  or  STD::strchr(name, ':') != NULL
+        or  fname[i-1] == '.'  or  fname[i-1] == ' ')
+        return INVALID_HANDLE_VALUE;
+
+    len = name - fname;
+    if (len > MAX_PATH)
+        return INVALID_HANDLE_VALUE;
+
+    for (i = 0;  i < len;  i++)
+        path[i] = (fname[i] == '/' ? '\\' : fname[i]);
+    path[len] = '\0';
+
+    // Convert the name into a native (Unicode) name
+    len = ::MultiByteToWideChar(CP_ACP, 0, name, -1, wname, MAX_PATH+1);
+    if (len <= 1)
+        return INVALID_HANDLE_VALUE;
+
+    us.Buffer = wname;
+    us.Length = (USHORT) ((len-1) * sizeof(WCHAR));
+    us.MaximumLength = (USHORT) (len * sizeof(WCHAR));
+
+    // Locate the directory of the file
+    dir = openDir(path);
+    if (dir == NULL)
+        return INVALID_HANDLE_VALUE;
+
+    // Open the file relative to its directory
+    InitializeObjectAttributes(&oa, &us, OBJ_CASE_INSENSITIVE, dir, NULL);
+
+    st = (*s_ntCreateFile)(
+            &h,
+            (ACCESS_MASK) GENERIC_WRITE | SYNCHRONIZE | FILE_READ_ATTRIBUTES,
+            &oa,
+            &iosb,
+            (PLARGE_INTEGER) NULL,
+            (ULONG) FILE_ATTRIBUTE_NORMAL,
+            (ULONG) FILE_SHARE_READ,
+            (ULONG) FILE_OPEN,
+            (ULONG) FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT,
+            (PVOID) NULL,
+            (ULONG) 0);
+
+    if (not NT_SUCCESS(st))
+        return INVALID_HANDLE_VALUE;
+
+    return h;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirTimes::ChtimeDirTimes()
+//	Default constructor.
+//------------------------------------------------------------------------------
+
+/*void*/ ChtimeDirTimes::ChtimeDirTimes():
+    m_ents(NULL),
+    m_size(0),
+    m_cnt(0),
+    m_lock()
+{
+#if ChtimeDirTimes_VS != 110
+ #error Class ChtimeDirTimes has changed
+#endif
+
+    // Initialize
+    ::InitializeCriticalSection(&m_lock);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirTimes::~ChtimeDirTimes()
+//	Destructor.
+//------------------------------------------------------------------------------
+
+/*void*/ ChtimeDirTimes::~ChtimeDirTimes()
+{
+#if ChtimeDirTimes_VS != 110
+ #error Class ChtimeDirTimes has changed
+#endif
+
+    // Deallocate the recorded directories
+    for (int i = 0;  i < m_size;  i++)
+        delete[] m_ents[i].path;
+
+    delete[] m_ents;
+    m_ents = NULL;
+    m_size = 0;
+    m_cnt = 0;
+
+    ::DeleteCriticalSection(&m_lock);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirTimes::lookup()
+//	Locate the hash table entry for a directory.
+//
+// Param	path
+//	The full path of a directory.
+//
+// Param	hash
+//	The hash value of 'path'.
+//
+// Returns
+//	Pointer to the entry for 'path', or to the empty entry where it belongs.
+//------------------------------------------------------------------------------
+
+ChtimeDirTimes::Entry * ChtimeDirTimes::lookup(const char *path,
+    unsigned long hash)
+{
+    int		i;
+
+    // Probe the table, starting at the hashed position
+    for (i = (int) (hash & (m_size-1));  ;  i = (i+1) & (m_size-1))
+    {
+        Entry *		e;
+        const char *	a;
+        const char *	b;
+
+        e = &m_ents[i];
+        if (e->path == NULL)
+            return e;
+        if (e->hash != hash)
+            continue;
+
+        // Compare the paths, ignoring case
+        for (a = e->path, b = path;  *a != '\0';  a++, b++)
+        {
+            if (STD::tolower((unsigned char) *a) !=
+                    STD::tolower((unsigned char) *b))
+                break;
+        }
+        if (*a == *b)
+            return e;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirTimes::grow()
+//	Double the size of the hash table, rehashing all of its entries.
+//------------------------------------------------------------------------------
+
+void ChtimeDirTimes::grow()
+{
+    Entry *	old;
+    int		oldSize;
+    int		i;
+
+    // Allocate a larger (empty) table
+    old = m_ents;
+    oldSize = m_size;
+    m_size = (m_size == 0 ? TIMES_INIT : m_size*2);
+    m_ents = new Entry[m_size];
+
+    for (i = 0;  i < m_size;  i++)
+        m_ents[i].path = NULL;
+
+    // Move the existing entries into the new table
+    for (i = 0;  i < oldSize;  i++)
+    {
+        if (old[i].path != NULL)
+            *lookup(old[i].path, old[i].hash) = old[i];
+    }
+
+    delete[] old;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirTimes::dirPath()
+//	Determine the full path of the directory containing a file.
+//
+// Param	fname
+//	The name of a file.
+//
+// Param	path
+//	A buffer of 'MAX_PATH'+1 characters, which is filled in with the full
+//	directory path, ending with a '\' separator.
+//
+// Returns
+//	True on success, or false if the path can't be determined or is too
+//	long.
+//------------------------------------------------------------------------------
+
+/*static*/
+bool ChtimeDirTimes::dirPath(const char *fname, char *path)
+{
+    char *	name;
+    DWORD	len;
+
+    len = ::GetFullPathName((LPCSTR) fname, MAX_PATH+1, path, &name);
+    if (len == 0  or  len > MAX_PATH  or  name == NULL)
+        return false;
+
+    *name = '\0';
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirTimes::record()
+//	Record the timestamps of the directory containing a file, unless they
+//	have already been recorded.
+//
+// Param	fname
+//	The name of a file about to be created.
+//------------------------------------------------------------------------------
+
+void ChtimeDirTimes::record(const char *fname)
+{
+    char		path[MAX_PATH+1];
+    unsigned long	hash;
+    Entry *		e;
+    HANDLE		h;
+
+    // Determine the full path of the file's directory
+    if (not dirPath(fname, path))
+        return;
+
+    ::EnterCriticalSection(&m_lock);
+
+    // Find the directory, or add a new entry for it
+    if (m_cnt*2 >= m_size)
+        grow();
+
+    hash = ChtimePlan::hashPath(path);
+    e = lookup(path, hash);
+    if (e->path != NULL)
+        goto done;
+
+    e->path = new char[STD::strlen(path)+1];
+    STD::strcpy(e->path, path);
+    e->hash = hash;
+    e->valid = false;
+    e->created = false;
+    m_cnt++;
+
+    // Retrieve the directory's timestamps
+    h = ::CreateFile(
+            (LPCSTR) path,
+            (DWORD) FILE_READ_ATTRIBUTES,
+            (DWORD) FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            (LPSECURITY_ATTRIBUTES) NULL,
+            (DWORD) OPEN_EXISTING,
+            (DWORD) FILE_FLAG_BACKUP_SEMANTICS,	// Required for a directory
+            (HANDLE) NULL);
+
+    if (h == INVALID_HANDLE_VALUE)
+        goto done;
+
+    if (::GetFileTime(h, (FILETIME *) NULL, &e->atime, &e->mtime))
+        e->valid = true;
+
+    ::CloseHandle(h);
+
+done:
+    ::LeaveCriticalSection(&m_lock);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirTimes::created()
+//	Note that a file has been created within its (recorded) directory, so
+//	that the timestamps of the directory are restored.
+//
+// Param	fname
+//	The name of a file that was created, after 'record()' was called for it.
+//------------------------------------------------------------------------------
+
+void ChtimeDirTimes::created(const char *fname)
+{
+    char	path[MAX_PATH+1];
+    Entry *	e;
+
+    // Determine the full path of the file's directory
+    if (not dirPath(fname, path))
+        return;
+
+    // Mark the directory, if it was recorded
+    ::EnterCriticalSection(&m_lock);
+    if (m_size > 0)
+    {
+        e = lookup(path, ChtimePlan::hashPath(path));
+        if (e->path != NULL)
+            e->created = true;
+    }
+    ::LeaveCriticalSection(&m_lock);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeDirTimes::restore()
+//	Restore the recorded timestamps of all of the directories in which files
+//	have been created.  The directories remain recorded, so this may be
+//	called again after more files are created.
+//
+// Param	dname
+//	Pointer to a directory name, which is set to the first directory whose
+//	timestamps could not be restored on failure.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, or one of the
+//	'ChtimePlan::RC_XXX' status codes on failure.
+//------------------------------------------------------------------------------
+
+int ChtimeDirTimes::restore(const char **dname)
+{
+    int		err =	ChtimePlan::RC_OKAY;
+    int		i;
+
+    ::EnterCriticalSection(&m_lock);
+
+    for (i = 0;  i < m_size;  i++)
+    {
+        Entry *		e;
+        HANDLE		h;
+        int		rc;
+
+        // Restore the next recorded directory, if a file was created in it
+        e = &m_ents[i];
+        if (e->path == NULL  or  not e->valid  or  not e->created)
+            continue;
+
+        rc = ChtimePlan::RC_OKAY;
+        h = ::CreateFile(
+                (LPCSTR) e->path,
+                (DWORD) FILE_WRITE_ATTRIBUTES,
+                (DWORD) FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                (LPSECURITY_ATTRIBUTES) NULL,
+                (DWORD) OPEN_EXISTING,
+                (DWORD) FILE_FLAG_BACKUP_SEMANTICS,
+                (HANDLE) NULL);
+
+        if (h == INVALID_HANDLE_VALUE)
+            rc = ChtimePlan::RC_WRITE;
+        else
+        {
+            if (not ::SetFileTime(h, (FILETIME *) NULL, &e->atime, &e->mtime))
+                rc = ChtimePlan::RC_TIME;
+            ::CloseHandle(h);
+        }
+
+        if (rc != ChtimePlan::RC_OKAY  and  err == ChtimePlan::RC_OKAY)
+        {
+            err = rc;
+            *dname = e->path;
+        }
+    }
+
+    ::LeaveCriticalSection(&m_lock);
+    return err;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeReporter::~ChtimeReporter()
+//	Destructor.
+//------------------------------------------------------------------------------
+
+/*void*/ ChtimeReporter::~ChtimeReporter()
+{
+#if ChtimeReporter_VS != 100
+ #error Class ChtimeReporter has changed
+#endif
+
+    // Nothing to do
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeReporter::progress()
+//	Receive the progress of a search for the files matching a wildcarded
+//	filename.  The default implementation does nothing.
+//
+// Param	fname
+//	The name of the last matching file whose outcome has been reported.
+//
+// Param	match
+//	The number of matching files (whether or not they were selected) whose
+//	outcomes have been reported.
+//------------------------------------------------------------------------------
+
+void ChtimeReporter::progress(const char *fname, long match)
+{
+    // Nothing to do
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::ChtimeExecutor()
+//	Constructor.
+//
+// Param	plan
+//	The plan to apply, which must outlive this executor.
+//------------------------------------------------------------------------------
+
+/*void*/ ChtimeExecutor::ChtimeExecutor(const ChtimePlan &plan):
+    m_plan(plan),
+    m_mode(MO_CHANGE),
+    m_cache(NULL),
+    m_times(NULL),
+    m_depth(0),
+    m_threads(NULL),
+    m_port(NULL),
+    m_done(NULL),
+    m_pending(0),
+    m_batchNames(NULL),
+    m_batchDirs(NULL),
+    m_batchRes(NULL),
+    m_found(NULL),
+    m_foundPtrs(NULL),
+    m_foundDirs(NULL),
+    m_foundRes(NULL),
+    m_foundCnt(0),
+    m_doneName(NULL),
+    m_doneMatch(0)
+{
+#if ChtimeExecutor_VS != 190
+ #error Class ChtimeExecutor has changed
+#endif
+
+    // Nothing else to do
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::~ChtimeExecutor()
+//	Destructor.
+//------------------------------------------------------------------------------
+
+/*void*/ ChtimeExecutor::~ChtimeExecutor()
+{
+#if ChtimeExecutor_VS != 190
+ #error Class ChtimeExecutor has changed
+#endif
+
+    // Terminate the worker threads
+    stopWorkers();
+
+    // Clean up
+    delete[] m_found;
+    m_found = NULL;
+    delete[] m_foundPtrs;
+    m_foundPtrs = NULL;
+    delete[] m_foundDirs;
+    m_foundDirs = NULL;
+    delete[] m_foundRes;
+    m_foundRes = NULL;
+    delete[] m_doneName;
+    m_doneName = NULL;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::changeFile()
+//	Change the timestamp of a filename.
+//
+// Param	fname
+//	The name of a file to change.
+//
+// Param	res
+//	Pointer to a result, which is filled in with the outcome.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, or one of the
+//	'ChtimePlan::RC_XXX' status codes on failure.
+//------------------------------------------------------------------------------
+
+int ChtimeExecutor::changeFile(const char *fname, ChtimeResult *res)
+{
+    return changeEntry(fname, false, m_cache, res);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::changeEntry()
+//	Change the timestamp of a file or a directory.
+//
+// Param	fname
+//	The name of a file or directory to change.
+//
+// Param	dir
+//	True if 'fname' names a directory, which must be opened with backup
+//	semantics (and not relative to the directory handle cache).
+//
+// Param	cache
+//	The directory handle cache owned by the calling thread, or null.
+//
+// Param	res
+//	Pointer to a result, which is filled in with the outcome.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, or one of the
+//	'ChtimePlan::RC_XXX' status codes on failure.
+//------------------------------------------------------------------------------
+
+int ChtimeExecutor::changeEntry(const char *fname, bool dir,
+    ChtimeDirCache *cache, ChtimeResult *res)
+{
+    HANDLE	h;
+    FILETIME	otime;
+
+    // Initialize
+    res->fname = fname;
+    res->rc = ChtimePlan::RC_OKAY;
+    res->msg = NULL;
+    res->skipped = false;
+    res->changed = false;
+
+    // Open the (existing) file, relative to its cached directory if possible
+    h = INVALID_HANDLE_VALUE;
+    if (cache != NULL  and  not dir)
+        h = cache->openFile(fname);
+
+    if (h == INVALID_HANDLE_VALUE)
+    {
+        h = ::CreateFile(
+                (LPCSTR) fname,
+                (DWORD) GENERIC_WRITE,	// Write required to change a time
+                (DWORD) FILE_SHARE_READ,
+                (LPSECURITY_ATTRIBUTES) NULL,
+                (DWORD) OPEN_EXISTING,
+                (DWORD) (dir ? FILE_FLAG_BACKUP_SEMANTICS : 0),
+                (HANDLE) NULL);
+    }
+
+    if (h == INVALID_HANDLE_VALUE)
+    {
+        res->msg = "Can't write";
+        res->rc = ChtimePlan::RC_WRITE;
+        return res->rc;
+    }
+
+    // Retrieve the file's timestamp
+    if (not ::GetFileTime(h, (FILETIME *) NULL, (FILETIME *) NULL,
+            &res->mtime))
+    {
+        res->msg = "Can't get timestamp for";
+        res->rc = ChtimePlan::RC_TIME;
+        goto done;
+    }
+    otime = res->mtime;
+
+    // Leave the file alone if it is already older than the clamp time
+    if (m_plan.isClamped(&res->mtime))
+    {
+        res->skipped = true;
+        goto done;
+    }
+
+    // Determine the file's new timestamp
+    res->rc = m_plan.newTime(&res->mtime, &res->msg);
+    if (res->rc != ChtimePlan::RC_OKAY)
+        goto done;
+
+    // Update the file's modification timestamp, unless it is unchanged
+    if (::CompareFileTime(&otime, &res->mtime) == 0)
+        goto done;
+
+    if (not ::SetFileTime(h, (FILETIME *) NULL, (FILETIME *) NULL,
+            &res->mtime))
+    {
+        res->msg = "Can't modify timestamp for";
+        res->rc = ChtimePlan::RC_TIME;
+        goto done;
+    }
+    res->changed = true;
+
+    // Retrieve the file's new timestamp, as stored by the file system
+    if (m_plan.m_readBack)
+    {
+        if (not ::GetFileTime(h, (FILETIME *) NULL, (FILETIME *) NULL,
+                &res->mtime))
+        {
+            res->msg = "Can't get new timestamp for";
+            res->rc = ChtimePlan::RC_TIME;
+            goto done;
+        }
+    }
+
+done:
+    // Clean up
+    ::CloseHandle(h);
+    h = (HANDLE) NULL;
+
+    return res->rc;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::createFile()
+//	Create a new (empty) file, and change its timestamp.
+//
+// Param	fname
+//	The name of a file to create.
+//
+// Param	res
+//	Pointer to a result, which is filled in with the outcome.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, or one of the
+//	'ChtimePlan::RC_XXX' status codes on failure.
+//------------------------------------------------------------------------------
+
+int ChtimeExecutor::createFile(const char *fname, ChtimeResult *res)
+{
+    HANDLE	h;
+
+    // Record the timestamps of the directory before it is modified
+    if (m_times != NULL)
+        m_times->record(fname);
+
+    // Create a new file with the current date/time
+    h = ::CreateFile(
+            (LPCSTR) fname,
+            (DWORD) GENERIC_WRITE,
+            (DWORD) FILE_SHARE_READ,
+            (LPSECURITY_ATTRIBUTES) NULL,
+            (DWORD) CREATE_NEW,
+            (DWORD) 0,
+            (HANDLE) NULL);
+
+    if (h == INVALID_HANDLE_VALUE)
+    {
+        // Can't create a new file (possibly a wildcard name)
+        res->fname = fname;
+        res->msg = "Can't create";
+        res->rc = ChtimePlan::RC_CREATE;
+        res->skipped = false;
+        res->changed = false;
+        return res->rc;
+    }
+
+    ::CloseHandle(h);
+
+    // Restore the timestamps of the directory later
+    if (m_times != NULL)
+        m_times->created(fname);
+
+    // Modify the timestamp of the new file, by its full name, since this
+    // may be called by any of the worker threads
+    return changeEntry(fname, false, NULL, res);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::changeOne()
+//	Change the timestamp of a single filename of a batch.
+//
+//	A filename that does not belong to the shard of the plan is skipped.
+//	A filename that does not exist is created if the plan specifies it.
+//
+// Param	fname
+//	The name of a file to change (without wildcards).
+//
+// Param	dir
+//	True if 'fname' names a directory.
+//
+// Param	cache
+//	The directory handle cache owned by the calling thread, or null.
+//
+// Param	res
+//	Pointer to a result, which is filled in with the outcome.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, or one of the
+//	'ChtimePlan::RC_XXX' status codes on failure.
+//------------------------------------------------------------------------------
+
+int ChtimeExecutor::changeOne(const char *fname, bool dir,
+    ChtimeDirCache *cache, ChtimeResult *res)
+{
+    int		rc;
+
+    if (not m_plan.inShard(fname))
+    {
+        res->fname = fname;
+        res->rc = ChtimePlan::RC_OKAY;
+        res->msg = NULL;
+        res->skipped = true;
+        res->changed = false;
+        return res->rc;
+    }
+
+    rc = changeEntry(fname, dir, cache, res);
+    if (rc == ChtimePlan::RC_WRITE  and  m_plan.m_create  and  not dir
+        and  ::GetLastError() == ERROR_FILE_NOT_FOUND)
+        rc = createFile(fname, res);
+
+    return rc;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::changeFiles()
+//	Change the timestamps of a batch of filenames.
+//
+//	Filenames that do not belong to the shard of the plan are skipped.
+//	Filenames that do not exist are created if the plan specifies it.
+//
+//	If worker threads have been started by 'setQueueDepth()', the filenames
+//	are queued for them, and the call returns once they have all been
+//	changed.  Otherwise they are changed one at a time.
+//
+// Param	fnames
+//	The names of the files to change (without wildcards).
+//
+// Param	n
+//	The number of filenames in 'fnames'.
+//
+// Param	res
+//	Array of 'n' results, which are filled in with the outcome for each
+//	filename.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) if all the files were changed, otherwise
+//	the first of the 'ChtimePlan::RC_XXX' status codes for the files that
+//	could not be changed.
+//------------------------------------------------------------------------------
+
+int ChtimeExecutor::changeFiles(const char *const *fnames, int n,
+    ChtimeResult *res)
+{
+    return runBatch(fnames, NULL, n, res);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::runBatch()
+//	Change the timestamps of a batch of files and directories, as for
+//	'changeFiles()'.
+//
+// Param	fnames
+//	The names of the files to change (without wildcards).
+//
+// Param	dirs
+//	Array of 'n' flags, each true if the corresponding filename names a
+//	directory, or null if none of them do.
+//
+// Param	n
+//	The number of filenames in 'fnames'.
+//
+// Param	res
+//	Array of 'n' results, which are filled in with the outcome for each
+//	filename.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) if all the files were changed, otherwise
+//	the first of the 'ChtimePlan::RC_XXX' status codes for the files that
+//	could not be changed.
+//------------------------------------------------------------------------------
+
+int ChtimeExecutor::runBatch(const char *const *fnames, const bool *dirs,
+    int n, ChtimeResult *res)
+{
+    int		err =	ChtimePlan::RC_OKAY;
+    int		i;
+
+    if (m_port != NULL  and  n > 1)
+    {
+        // Queue the filenames for the worker threads
+        m_batchNames = fnames;
+        m_batchDirs = dirs;
+        m_batchRes = res;
+        m_pending = n;
+        ::ResetEvent(m_done);
+
+        for (i = 0;  i < n;  i++)
+        {
+            if (not ::PostQueuedCompletionStatus(m_port, 0,
+                    (ULONG_PTR) i+1, (OVERLAPPED *) NULL))
+            {
+                // Can't queue the file, so change it here instead
+                changeOne(fnames[i], dirs != NULL  and  dirs[i], m_cache,
+                    &res[i]);
+                if (::InterlockedDecrement(&m_pending) == 0)
+                    ::SetEvent(m_done);
+            }
+        }
+
+        // Wait for the worker threads to change all of the files
+        ::WaitForSingleObject(m_done, INFINITE);
+        m_batchNames = NULL;
+        m_batchDirs = NULL;
+        m_batchRes = NULL;
+    }
+    else
+    {
+        // Change the files one at a time
+        for (i = 0;  i < n;  i++)
+            changeOne(fnames[i], dirs != NULL  and  dirs[i], m_cache,
+                &res[i]);
+    }
+
+    // Determine the first failure
+    for (i = 0;  i < n;  i++)
+    {
+        if (err == ChtimePlan::RC_OKAY)
+            err = res[i].rc;
+    }
+
+    return err;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::changePattern()
+//	Change the timestamps of the files matching a wildcarded filename.
+//
+//	Each matching file that is selected by the filters of the plan, belongs
+//	to its shard, and is not already within its clamp time is changed (or
+//	listed, according to the mode).  In 'MO_TAR' mode, the members of each
+//	archive file that is selected and belongs to the shard are changed
+//	instead, each member being clamped by its own time.  If the plan selects
+//	directories ('--type d'), the matching directories are changed the same
+//	way, except for the '.' and '..' entries; otherwise a matching directory
+//	is opened as a file.  If no file matches and the plan specifies it, a new file is
+//	created.
+//
+//	The outcome for each file is passed to a reporter, in the order in which
+//	the files were found, followed by the progress of the search.
+//
+// Param	pat
+//	Filename pattern, which may contain wildcard characters ('?' and '*').
+//
+// Param	rep
+//	The reporter receiving the outcome for each file.
+//
+// Param	skip
+//	The number of matching files to skip, which were changed by a previous
+//	run.
+//
+// Param	skipName
+//	The full name of the last file changed by the previous run, or null.
+//	If the last skipped file has a different name (or fewer files match),
+//	the matching files have changed since that run, and none are skipped.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, otherwise the first of the
+//	'ChtimePlan::RC_XXX' status codes returned by the reporter.
+//------------------------------------------------------------------------------
+
+int ChtimeExecutor::changePattern(const char *pat, ChtimeReporter *rep,
+    long skip, const char *skipName)
+{
+    int			err =	ChtimePlan::RC_OKAY;
+    HANDLE		fh;
+    WIN32_FIND_DATA	fs;
+    ChtimeResult	res;
+    char *		fnamep;
+    char		fpath[32*1024+1];
+    int			len;
+    long		match;
+    bool		dir;
+
+search:
+    // Set up the filename search
+    fh = ::FindFirstFile((LPCSTR) pat, (WIN32_FIND_DATA *) &fs);
+
+    if (fh == INVALID_HANDLE_VALUE)
+    {
+        if (m_plan.m_create)
+        {
+            // Skip the file if it was created by a previous run, or if it
+            // belongs to another shard
+            if (skip > 0  or  not m_plan.inShard(pat))
+                return ChtimePlan::RC_OKAY;
+
+            // Create a new file, and modify its timestamp
+            createFile(pat, &res);
+            err = rep->report(&res);
+
+            // Record the progress
+            rep->progress(pat, 1);
+            return err;
+        }
+
+        // Can't find any matching filenames
+        res.fname = pat;
+        res.rc = ChtimePlan::RC_FIND;
+        res.msg = "Can't find";
+        res.skipped = false;
+        res.changed = false;
+        return rep->report(&res);
+    }
+
+    // Initialize the full filename path, leaving room for any found name
+    len = ChtimePlan::splitPath(pat, fpath, (int) sizeof(fpath)-1 - MAX_PATH);
+    if (len < 0)
+    {
+        ::FindClose(fh);
+        res.fname = pat;
+        res.rc = ChtimePlan::RC_FIND;
+        res.msg = "Filename too long";
+        res.skipped = false;
+        res.changed = false;
+        return rep->report(&res);
+    }
+    fnamep = fpath + len;
+
+    // Search for one or more matching filenames
+    for (match = 0;  ;  )
+    {
+        int	rc =	ChtimePlan::RC_OKAY;
+
+        // Change the timestamp of the next matching filename
+        STD::strcpy(fnamep, (const char *) fs.cFileName);
+        dir = (m_plan.m_typeDir
+            and  (fs.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+        if (match < skip)
+        {
+            // Skip the file, changed by a previous run, unless the previous
+            // run did not end with this file
+            if (match == skip-1  and  skipName != NULL
+                and  STD::strcmp(fpath, skipName) != 0)
+                goto restart;
+        }
+        else if (dir  and  (STD::strcmp(fnamep, ".") == 0
+            or  STD::strcmp(fnamep, "..") == 0))
+        {
+            // Skip the directory itself and its parent
+        }
+        else if (not m_plan.isSelected(&fs))
+        {
+            // Skip the file, rejected by the filters
+        }
+        else if (not m_plan.inShard(fpath))
+        {
+            // Skip the file, in another shard
+        }
+        else if (m_mode == MO_TAR)
+            rc = changeArchive(fpath, rep);
+        else if (m_plan.isClamped(&fs.ftLastWriteTime))
+        {
+            // Skip the file, within the clamp time
+        }
+        else if (m_mode == MO_LIST)
+        {
+            // Report the timestamp found by the search
+            res.fname = fpath;
+            res.rc = ChtimePlan::RC_OKAY;
+            res.msg = NULL;
+            res.skipped = false;
+            res.changed = false;
+            res.mtime = fs.ftLastWriteTime;
+            rc = rep->report(&res);
+        }
+        else if (m_port != NULL)
+            rc = addFound(fpath, dir, rep);
+        else
+        {
+            changeEntry(fpath, dir, m_cache, &res);
+            rc = rep->report(&res);
+        }
+
+        if (err == ChtimePlan::RC_OKAY)
+            err = rc;
+
+        // Record the progress
+        match++;
+        advance(fpath, match, rep);
+
+        // Search for the next matching filename
+        if (not ::FindNextFile(fh, (WIN32_FIND_DATA *) &fs))
+            break;
+    }
+
+    // Fewer files match than were changed by the previous run
+    if (match < skip  and  skipName != NULL)
+        goto restart;
+
+    // Change the remaining batched filenames
+    {
+        int	rc;
+
+        rc = flushFound(rep);
+        if (err == ChtimePlan::RC_OKAY)
+            err = rc;
+    }
+
+    // Clean up
+    ::FindClose(fh);
+    fh = (HANDLE) NULL;
+
+    return err;
+
+restart:
+    // The matching files have changed since the previous run, so search for
+    // all of them again
+    ::FindClose(fh);
+    fh = (HANDLE) NULL;
+    skip = 0;
+    goto search;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::addFound()
+//	Add a found filename to the batch of filenames to change, changing the
+//	batch first if it is full.  A filename too long to batch is changed
+//	directly, once the batch has been changed.
+//
+// Param	fname
+//	The name of a file.
+//
+// Param	dir
+//	True if 'fname' names a directory.
+//
+// Param	rep
+//	The reporter receiving the outcome for each file.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, otherwise the first of the
+//	'ChtimePlan::RC_XXX' status codes returned by the reporter.
+//------------------------------------------------------------------------------
+
+int ChtimeExecutor::addFound(const char *fname, bool dir, ChtimeReporter *rep)
+{
+    int		rc =	ChtimePlan::RC_OKAY;
+
+    // Change a filename that is too long to batch directly, after the
+    // filenames batched before it, so the outcomes stay in order
+    if (STD::strlen(fname) > MAX_PATH)
+    {
+        ChtimeResult	res;
+        int		err;
+
+        rc = flushFound(rep);
+        changeEntry(fname, dir, m_cache, &res);
+        err = rep->report(&res);
+        if (rc == ChtimePlan::RC_OKAY)
+            rc = err;
+        return rc;
+    }
+
+    // Change the full batch
+    if (m_foundCnt >= QUEUE_BATCH)
+        rc = flushFound(rep);
+
+    // Add the filename to the batch
+    STD::strcpy(&m_found[m_foundCnt*(MAX_PATH+1)], fname);
+    m_foundDirs[m_foundCnt] = dir;
+    m_foundCnt++;
+    return rc;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::flushFound()
+//	Change the timestamps of the batched found filenames, using the worker
+//	threads, and report the outcome for each of them in order.
+//
+// Param	rep
+//	The reporter receiving the outcome for each file.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, otherwise the first of the
+//	'ChtimePlan::RC_XXX' status codes returned by the reporter.
+//------------------------------------------------------------------------------
+
+int ChtimeExecutor::flushFound(ChtimeReporter *rep)
+{
+    int		err =	ChtimePlan::RC_OKAY;
+    int		i;
+
+    if (m_foundCnt == 0)
+        return ChtimePlan::RC_OKAY;
+
+    // Change the batched files
+    for (i = 0;  i < m_foundCnt;  i++)
+        m_foundPtrs[i] = &m_found[i*(MAX_PATH+1)];
+
+    runBatch(m_foundPtrs, m_foundDirs, m_foundCnt, m_foundRes);
+
+    // Report the outcomes
+    for (i = 0;  i < m_foundCnt;  i++)
+    {
+        int	rc;
+
+        rc = rep->report(&m_foundRes[i]);
+        if (err == ChtimePlan::RC_OKAY)
+            err = rc;
+    }
+    m_foundCnt = 0;
+
+    // Report the progress deferred until the batch was changed
+    if (m_doneMatch > 0)
+        rep->progress(m_doneName, m_doneMatch);
+    m_doneMatch = 0;
+
+    return err;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::advance()
+//	Report the progress of a filename search, once all of the matching files
+//	found so far have been changed.
+//
+// Param	fname
+//	The name of the last matching file.
+//
+// Param	match
+//	The number of matching files found so far.
+//
+// Param	rep
+//	The reporter receiving the progress.
+//------------------------------------------------------------------------------
+
+void ChtimeExecutor::advance(const char *fname, long match,
+    ChtimeReporter *rep)
+{
+    if (m_foundCnt == 0)
+    {
+        rep->progress(fname, match);
+        return;
+    }
+
+    // Defer the progress until the batched files have been changed
+    STD::strcpy(m_doneName, fname);
+    m_doneMatch = match;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::getTarNumber()
+//	Retrieve a numeric field from a tar archive header.
+//
+// Param	f
+//	The header field, containing either a string of octal digits, or a
+//	big-endian base-256 number (if the first byte has its high bit set).
+//
+// Param	len
+//	The size of the header field.
+//
+// Param	v
+//	Pointer to a number, which is filled in with the value of field 'f'.
+//
+// Returns
+//	True if the field is correctly formed and not negative, otherwise false.
+//------------------------------------------------------------------------------
+
+/*static*/
+bool ChtimeExecutor::getTarNumber(const BYTE *f, int len, ULONGLONG *v)
+{
+    int		i;
+
+    *v = 0;
+    if (f[0] & 0x80)
+    {
+        // Extract a base-256 number
+        if (f[0] & 0x40)
+            return false;
+
+        *v = f[0] & 0x3F;
+        for (i = 1;  i < len;  i++)
+        {
+            if (*v >> 56 != 0)
+                return false;
+            *v = (*v << 8) | f[i];
+        }
+        return true;
+    }
+
+    // Extract an octal number
+    for (i = 0;  i < len  and  f[i] == ' ';  i++)
+        ;
+    for ( ;  i < len  and  f[i] >= '0'  and  f[i] <= '7';  i++)
+        *v = (*v << 3) | (f[i] - '0');
+    return (i == len  or  f[i] == ' '  or  f[i] == '\0');
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::putTarNumber()
+//	Store a numeric field into a tar archive header.
+//
+// Param	f
+//	The header field, which is filled in with 'len'-1 octal digits and a
+//	terminating null, or with a big-endian base-256 number if the value is
+//	too large to be written in octal.
+//
+// Param	len
+//	The size of the header field.
+//
+// Param	v
+//	The value to store.
+//------------------------------------------------------------------------------
+
+/*static*/
+void ChtimeExecutor::putTarNumber(BYTE *f, int len, ULONGLONG v)
+{
+    int		i;
+
+    if (v >> 3*(len-1) == 0)
+    {
+        // Store an octal number
+        f[len-1] = '\0';
+        for (i = len-2;  i >= 0;  i--, v >>= 3)
+            f[i] = (BYTE) ('0' + (v & 07));
+    }
+    else
+    {
+        // Store a base-256 number
+        for (i = len-1;  i > 0;  i--, v >>= 8)
+            f[i] = (BYTE) (v & 0xFF);
+        f[0] = 0x80;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::putPaxTime()
+//	Store a time into the value of a pax extended header record, without
+//	changing the length of the value.
+//
+// Param	f
+//	The value of the record, which is filled in with the decimal number of
+//	seconds, padded with fractional digits or with leading zeros.
+//
+// Param	len
+//	The length of the value.
+//
+// Param	secs
+//	Number of seconds since 1970-01-01 00:00:00 UTC.
+//
+// Param	ticks
+//	Additional number of 100-nanosecond ticks.
+//
+// Returns
+//	True if the time fits within the value, otherwise false, in which case
+//	nothing is stored.
+//------------------------------------------------------------------------------
+
+/*static*/
+bool ChtimeExecutor::putPaxTime(BYTE *f, int len, ULONGLONG secs, DWORD ticks)
+{
+    char	buf[40+1];
+    int		n;
+    int		i;
+
+    // Format the whole seconds
+    n = 0;
+    do
+    {
+        buf[n++] = (char) ('0' + secs%10);
+        secs /= 10;
+    } while (secs != 0);
+
+    if (n > len)
+        return false;
+
+    if (len - n == 1)
+    {
+        // Pad the seconds with a leading zero
+        buf[n++] = '0';
+    }
+
+    for (i = 0;  i < n;  i++)
+        f[i] = buf[n-1-i];
+
+    if (n < len)
+    {
+        // Append the fractional seconds, padded with zeros
+        f[n++] = '.';
+        for (i = 0;  n < len;  i++)
+        {
+            f[n++] = (BYTE) (i < 7 ? '0' + ticks/1000000 : '0');
+            ticks = ticks%1000000 * 10;
+        }
+    }
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::mapArchive()
+//	Map a part of an archive file into memory.
+//
+//	The archive is mapped in views of 'TAR_WINDOW' bytes, so that archives
+//	larger than the address space can be changed.  A new view is mapped only
+//	if the requested part is not within the current view.
+//
+// Param	m
+//	The mapped archive file.
+//
+// Param	off
+//	File offset of the part to map.
+//
+// Param	len
+//	Length of the part to map.
+//
+// Returns
+//	Pointer to the mapped part at offset 'off', or null on failure.
+//------------------------------------------------------------------------------
+
+/*static*/
+BYTE * ChtimeExecutor::mapArchive(TarMap *m, ULONGLONG off, DWORD len)
+{
+    ULONGLONG	base;
+    ULONGLONG	n;
+
+    // Check for a part within the current view
+    if (off + len > m->size)
+        return NULL;
+    if (m->view != NULL
+        and  off >= m->viewOff  and  off + len <= m->viewOff + m->viewLen)
+        return m->view + (off - m->viewOff);
+
+    // Map a new view containing the part
+    if (m->view != NULL)
+        ::UnmapViewOfFile(m->view);
+
+    base = off - off%TAR_GRAIN;
+    n = off - base + len;
+    if (n < TAR_WINDOW)
+        n = TAR_WINDOW;
+    if (n > m->size - base)
+        n = m->size - base;
+
+    m->view = (BYTE *) ::MapViewOfFile(m->map, FILE_MAP_WRITE,
+        (DWORD) (base >> 32), (DWORD) base, (size_t) n);
+    if (m->view == NULL)
+        return NULL;
+
+    m->viewOff = base;
+    m->viewLen = n;
+    return m->view + (off - base);
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::changeArchive()
+//	Change the timestamps of the members of a tar archive file.
+//
+//	The archive is modified in place.  Only the 'mtime' fields (and the
+//	checksums) of the ustar member headers, and the 'mtime' records of pax
+//	extended headers, are rewritten; the member contents are not read.  A
+//	member whose pax record is too short to hold its new time is left
+//	unchanged, and is reported as a failure.
+//
+//	The outcome for each member changed (named as "ARCHIVE(MEMBER)") is
+//	passed to a reporter, as is any failure to read the archive itself.
+//
+// Param	fname
+//	The name of a tar archive file to change.
+//
+// Param	rep
+//	The reporter receiving the outcome for each member.
+//
+// Returns
+//	'ChtimePlan::RC_OKAY' (zero) on success, otherwise the first of the
+//	'ChtimePlan::RC_XXX' status codes returned by the reporter.
+//------------------------------------------------------------------------------
+
+int ChtimeExecutor::changeArchive(const char *fname, ChtimeReporter *rep)
+{
+    int			err =	ChtimePlan::RC_OKAY;
+    ChtimeResult	res;
+    HANDLE		h;
+    TarMap		m;
+    LARGE_INTEGER	size;
+    ULONGLONG		off;
+    ULONGLONG		paxOff =	0;
+    int			paxLen =	0;
+    ULONGLONG		paxSecs =	0;
+    DWORD		paxTicks =	0;
+
+    // Open the (existing) archive file
+    m.map = (HANDLE) NULL;
+    m.view = NULL;
+    h = ::CreateFile(
+            (LPCSTR) fname,
+            (DWORD) GENERIC_READ | GENERIC_WRITE,
+            (DWORD) FILE_SHARE_READ,
+            (LPSECURITY_ATTRIBUTES) NULL,
+            (DWORD) OPEN_EXISTING,
+            (DWORD) 0,
+            (HANDLE) NULL);
+
+    if (h == INVALID_HANDLE_VALUE)
+    {
+        res.msg = "Can't write";
+        res.rc = ChtimePlan::RC_WRITE;
+        h = (HANDLE) NULL;
+        goto fail;
+    }
+
+    // Map the archive file into memory
+    if (not ::GetFileSizeEx(h, &size))
+    {
+        res.msg = "Can't read";
+        res.rc = ChtimePlan::RC_READ;
+        goto fail;
+    }
+
+    m.size = size.QuadPart;
+    if (m.size < TAR_BLOCK)
+        goto done;
+
+    m.map = ::CreateFileMapping(h, NULL, PAGE_READWRITE, 0, 0, NULL);
+    if (m.map == NULL)
+    {
+        res.msg = "Can't write";
+        res.rc = ChtimePlan::RC_WRITE;
+        goto fail;
+    }
+
+    // Change each member header
+    for (off = 0;  off + TAR_BLOCK <= m.size;  )
+    {
+        BYTE *		hdr;
+        ULONGLONG	len;
+        ULONGLONG	secs;
+        DWORD		ticks;
+        FILETIME	mtime;
+        unsigned long	sum;
+        char		label[32*1024+1];
+        int		rc;
+        int		i;
+
+        // Verify the next header
+        hdr = mapArchive(&m, off, TAR_BLOCK);
+        if (hdr == NULL)
+        {
+            res.msg = "Can't read";
+            res.rc = ChtimePlan::RC_READ;
+            goto fail;
+        }
+
+        for (i = 0;  i < TAR_BLOCK  and  hdr[i] == 0;  i++)
+            ;
+        if (i == TAR_BLOCK)
+            break;			// End of archive
+
+        for (sum = 8*' ', i = 0;  i < TAR_BLOCK;  i++)
+            sum += (i < 148  or  i >= 156 ? hdr[i] : 0);
+
+        if (not getTarNumber(&hdr[148], 8, &len)  or  len != sum
+            or  not getTarNumber(&hdr[124], 12, &len)
+            or  not getTarNumber(&hdr[136], 12, &secs)
+            or  len > m.size - off - TAR_BLOCK)
+        {
+            // Bad checksum or field, or member contents beyond the end of
+            // the archive
+            res.msg = "Bad archive header in";
+            res.rc = ChtimePlan::RC_READ;
+            goto fail;
+        }
+
+        off += TAR_BLOCK;
+
+        if (hdr[156] == 'x')
+        {
+            const BYTE *	p;
+            const BYTE *	end;
+
+            // Locate the 'mtime' record of a pax extended header
+            p = NULL;
+            if (len <= TAR_WINDOW)
+                p = mapArchive(&m, off, (DWORD) len);
+            if (p == NULL)
+            {
+                res.msg = "Bad archive header in";
+                res.rc = ChtimePlan::RC_READ;
+                goto fail;
+            }
+
+            for (end = p + len;  p < end;  )
+            {
+                const BYTE *	r;
+                const BYTE *	v;
+                int		rlen;
+
+                // Parse the next '"LEN key=value\n"' record
+                for (rlen = 0, r = p;  r < end  and  STD::isdigit(*r);  r++)
+                    rlen = rlen*10 + (*r - '0');
+                if (r == p  or  r >= end  or  *r != ' '
+                    or  rlen <= r - p  or  rlen > end - p
+                    or  p[rlen-1] != '\n')
+                    break;
+
+                if (end - r > 7  and  STD::strncmp((const char *) r,
+                        " mtime=", 7) == 0)
+                {
+                    // Extract the time of the record
+                    v = r + 7;
+                    paxOff = off + (v - (end - len));
+                    paxLen = (int) (p + rlen-1 - v);
+                    paxSecs = 0;
+                    paxTicks = 0;
+                    for (r = v;  STD::isdigit(*r);  r++)
+                        paxSecs = paxSecs*10 + (*r - '0');
+                    if (*r == '.')
+                    {
+                        for (i = 0, r++;  STD::isdigit(*r);  i++, r++)
+                        {
+                            if (i < 7)
+                                paxTicks = paxTicks*10 + (*r - '0');
+                        }
+                        for ( ;  i < 7;  i++)
+                            paxTicks *= 10;
+                    }
+                }
+
+                p += rlen;
+            }
+        }
+        else if (hdr[156] != 'g'  and  hdr[156] != 'L'  and  hdr[156] != 'K')
+        {
+            // Determine the current time of the member
+            ticks = 0;
+            if (paxLen > 0)
+            {
+                secs = paxSecs;
+                ticks = paxTicks;
+            }
+            ChtimePlan::toFileTime(secs, ticks, &mtime);
+
+            if (STD::memcmp(&hdr[257], "ustar", 6) == 0
+                and  hdr[345] != '\0')
+                STD::sprintf(label, "%s(%.155s/%.100s)", fname,
+                    (const char *) &hdr[345], (const char *) &hdr[0]);
+            else
+                STD::sprintf(label, "%s(%.100s)", fname,
+                    (const char *) &hdr[0]);
+
+            // Change the time of the member
+            res.fname = label;
+            res.rc = ChtimePlan::RC_OKAY;
+            res.msg = NULL;
+            res.skipped = m_plan.isClamped(&mtime);
+            res.changed = false;
+            res.mtime = mtime;
+
+            if (not res.skipped)
+                res.rc = m_plan.newTime(&res.mtime, &res.msg);
+
+            if (not res.skipped  and  res.rc == ChtimePlan::RC_OKAY)
+            {
+                ChtimePlan::fromFileTime(&res.mtime, &secs, &ticks);
+
+                if (paxLen > 0)
+                {
+                    BYTE *	v;
+
+                    // Change the time of the pax extended header record
+                    // first, mapped together with the member header, so
+                    // that the member is left alone if the record can't
+                    // hold the new time
+                    v = mapArchive(&m, paxOff, (DWORD) (off - paxOff));
+                    if (v == NULL  or  not putPaxTime(v, paxLen, secs, ticks))
+                    {
+                        res.msg = "Can't modify timestamp for";
+                        res.rc = ChtimePlan::RC_TIME;
+                    }
+                    else
+                        hdr = v + (off - TAR_BLOCK - paxOff);
+                }
+            }
+
+            if (not res.skipped  and  res.rc == ChtimePlan::RC_OKAY)
+            {
+                // Change the time of the member header
+                putTarNumber(&hdr[136], 12, secs);
+
+                for (sum = 8*' ', i = 0;  i < TAR_BLOCK;  i++)
+                    sum += (i < 148  or  i >= 156 ? hdr[i] : 0);
+                putTarNumber(&hdr[148], 7, sum);
+                hdr[155] = ' ';
+                res.changed = true;
+            }
+
+            // Report the change
+            rc = rep->report(&res);
+            if (err == ChtimePlan::RC_OKAY)
+                err = rc;
+
+            paxLen = 0;
+        }
+
+        // Skip the member contents
+        off += (len + TAR_BLOCK-1) / TAR_BLOCK * TAR_BLOCK;
+    }
+
+    goto done;
+
+fail:
+    // Failure, report the archive itself
+    {
+        int	rc;
+
+        res.fname = fname;
+        res.skipped = false;
+        res.changed = false;
+        rc = rep->report(&res);
+        if (err == ChtimePlan::RC_OKAY)
+            err = rc;
+    }
+
+done:
+    // Clean up
+    if (m.view != NULL)
+        ::UnmapViewOfFile(m.view);
+    m.view = NULL;
+    if (m.map != NULL)
+        ::CloseHandle(m.map);
+    m.map = (HANDLE) NULL;
+    if (h != (HANDLE) NULL)
+        ::CloseHandle(h);
+    h = (HANDLE) NULL;
+
+    return err;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::setQueueDepth()
+//	Start a pool of worker threads, which change the files of each batch
+//	passed to 'changeFiles()' concurrently.
+//
+//	The directory handle cache belongs to the calling thread, so each worker
+//	thread uses a separate cache of the same size instead.
+//
+// Param	n
+//	The number of worker threads, which is the number of files being changed
+//	at any one time, limited to 'QUEUE_MAX'.  If this is less than 2, the
+//	files are changed one at a time by the calling thread.
+//
+// Returns
+//	True on success, or false if the worker threads could not be started,
+//	in which case the files are changed one at a time.
+//------------------------------------------------------------------------------
+
+bool ChtimeExecutor::setQueueDepth(int n)
+{
+    // Terminate any existing worker threads
+    stopWorkers();
+
+    if (n < 2)
+        return true;
+    if (n > QUEUE_MAX)
+        n = QUEUE_MAX;
+
+    // Create the work queue
+    m_done = ::CreateEvent(NULL, TRUE, FALSE, NULL);
+    m_port = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, (HANDLE) NULL, 0,
+        (DWORD) n);
+    if (m_done == NULL  or  m_port == NULL)
+        goto fail;
+
+    // Start the worker threads
+    m_threads = new HANDLE[n];
+    for (m_depth = 0;  m_depth < n;  m_depth++)
+    {
+        HANDLE	h;
+
+        h = ::CreateThread(NULL, 0, &workerThread, this, 0, NULL);
+        if (h == NULL)
+            break;
+        m_threads[m_depth] = h;
+    }
+
+    if (m_depth == 0)
+        goto fail;
+
+    // Set up the batch of found filenames
+    if (m_found == NULL)
+    {
+        m_found = new char[QUEUE_BATCH*(MAX_PATH+1)];
+        m_foundPtrs = new const char *[QUEUE_BATCH];
+        m_foundDirs = new bool[QUEUE_BATCH];
+        m_foundRes = new ChtimeResult[QUEUE_BATCH];
+        m_doneName = new char[32*1024+1];
+    }
+    return true;
+
+fail:
+    // Failure, clean up
+    stopWorkers();
+    return false;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::workerThread()
+//	Worker thread entry point.
+//
+// Param	arg
+//	Pointer to the 'ChtimeExecutor' object.
+//
+// Returns
+//	Zero.
+//------------------------------------------------------------------------------
+
+/*static*/
+DWORD WINAPI ChtimeExecutor::workerThread(LPVOID arg)
+{
+    ((ChtimeExecutor *) arg)->runWorker();
+    return 0;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::runWorker()
+//	Change the queued files of the current batch, until a null entry is
+//	dequeued.
+//
+//	Each queue entry holds the index (plus one) of a filename within the
+//	current batch.  If the executor has a directory handle cache, the
+//	thread opens the files through a cache of its own of the same size,
+//	which is kept across batches.
+//------------------------------------------------------------------------------
+
+void ChtimeExecutor::runWorker()
+{
+    ChtimeDirCache *	cache =	NULL;
+
+    for (;;)
+    {
+        DWORD		len;
+        ULONG_PTR	key;
+        OVERLAPPED *	ov;
+        int		i;
+
+        // Wait for the next queued file
+        if (not ::GetQueuedCompletionStatus(m_port, &len, &key, &ov,
+                INFINITE))
+            break;
+        if (key == 0)
+            break;
+
+        // Set up the directory handle cache of this thread
+        if (cache == NULL  and  m_cache != NULL)
+            cache = new ChtimeDirCache(m_cache->getSize());
+
+        // Change the file, and signal the end of the batch
+        i = (int) key - 1;
+        changeOne(m_batchNames[i], m_batchDirs != NULL  and  m_batchDirs[i],
+            cache, &m_batchRes[i]);
+        if (::InterlockedDecrement(&m_pending) == 0)
+            ::SetEvent(m_done);
+    }
+
+    // Clean up
+    delete cache;
+    cache = NULL;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::stopWorkers()
+//	Terminate the worker threads, and discard the work queue.
+//------------------------------------------------------------------------------
+
+void ChtimeExecutor::stopWorkers()
+{
+    int		i;
+
+    // Tell the worker threads to terminate, and wait for them
+    for (i = 0;  i < m_depth;  i++)
+        ::PostQueuedCompletionStatus(m_port, 0, 0, (OVERLAPPED *) NULL);
+    if (m_depth > 0)
+        ::WaitForMultipleObjects((DWORD) m_depth, m_threads, TRUE, INFINITE);
+
+    for (i = 0;  i < m_depth;  i++)
+        ::CloseHandle(m_threads[i]);
+
+    // Clean up
+    delete[] m_threads;
+    m_threads = NULL;
+    m_depth = 0;
+
+    if (m_port != NULL)
+        ::CloseHandle(m_port);
+    m_port = NULL;
+
+    if (m_done != NULL)
+        ::CloseHandle(m_done);
+    m_done = NULL;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::setDirCache()
+//	Open the files to change relative to their directories, using handles
+//	to the directories held in a cache.
+//
+// Param	cache
+//	The directory handle cache, which must outlive this executor, or null
+//	to open the files by their full names.
+//------------------------------------------------------------------------------
+
+void ChtimeExecutor::setDirCache(ChtimeDirCache *cache)
+{
+    m_cache = cache;
+}
+
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::setDirTimes()
+//	Record the timestamps of the directories in which new files are
+//	created, so that they can be restored afterwards.
+//
+// Param	times
+//	The recorded directory timestamps, which must outlive this executor, or
+//	null to leave the directories alone.
+//------------------------------------------------------------------------------
+
+void ChtimeExecutor::setDirTimes(ChtimeDirTimes *times)
+{
+    m_times = times;
+}
+
+//------------------------------------------------------------------------------
+// ChtimeExecutor::setMode()
+//	Set the operating mode, which determines what is done with the files
+//	found by 'changePattern()'.
+//
+// Param	mode
+//	One of the 'MO_XXX' operating modes.
+//------------------------------------------------------------------------------
+
+void ChtimeExecutor::setMode(int mode)
+{
+    m_mode = mode;
+}
+
+// End libchtime.cpp
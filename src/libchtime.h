@@ -0,0 +1,445 @@
+//==============================================================================
+// libchtime.h
+//	In-process interface for changing the modification timestamps of files.
+//
+// Notes
+//	This library is written for Microsoft Win32 only.
+//
+//	A 'ChtimePlan' describes how the timestamps are to be changed, and a
+//	'ChtimeExecutor' applies a plan to filenames, returning a 'ChtimeResult'
+//	for each one (or passing it to a 'ChtimeReporter').  No output is
+//	displayed and the program is never terminated by these classes; the
+//	'chtime' command is a wrapper around them.
+//
+// Copyright 2000-2010 by David R. Tribble, all rights reserved.
+//------------------------------------------------------------------------------
+
+#ifndef libchtime_h
+#define libchtime_h	1
+
+// System includes
+
+#ifndef _WIN32
+ #error Compile this under Win32 only
+#endif
+
+#define WIN32_LEAN_AND_MEAN	1
+#include <windows.h>
+
+
+//------------------------------------------------------------------------------
+// class ChtimePlan
+//	Specifies how the modification timestamps of files are to be changed.
+//
+//	A plan is filled in from the command line options (or their equivalent),
+//	and may be freely copied.
+//------------------------------------------------------------------------------
+
+#define ChtimePlan_VS	130			// Class version, 1.3
+
+class ChtimePlan
+{
+public: // Shared constants
+    enum StatusCodes				// Status codes
+    {
+        RC_OKAY =	0,	// Success
+        RC_READ =	1,	// Can't open/read a file
+        RC_WRITE =	2,	// Can't open/write a file
+        RC_TIME =	3,	// Can't get timestamp of a file
+        RC_FIND =	4,	// Can't find wildcarded filename
+        RC_CREATE =	5	// Can't create a new file
+    };
+
+    enum Filters				// File selection filters
+    {
+        FI_OLDER =	0x0001,	// Select files older than a time
+        FI_NEWER =	0x0002,	// Select files newer than a time
+        FI_SIZE =	0x0004,	// Select files within a size range
+        FI_TYPE =	0x0008,	// Select files or directories only
+        FI_EXCLUDE =	0x0010	// Reject files matching patterns
+    };
+
+    enum Limits					// Implementation limits
+    {
+        EXCLUDE_MAX =	32,	// Max excluded filename patterns
+        TIME_LEN =	24	// Max length of a formatted timestamp
+    };
+
+public: // Variables
+    bool		m_create;		// Create nonexistent files
+    bool		m_localTime;		// Use local time, not UTC
+    bool		m_readBack;		// Retrieve the new timestamps
+    int			m_year;			// Changed year number
+    int			m_mon;			// Changed month number
+    int			m_mday;			// Changed day of the month
+    int			m_hour;			// Changed hour number
+    int			m_min;			// Changed minute number
+    int			m_sec;			// Changed second number
+    int			m_msec;			// Changed millisecond number
+    bool		m_useTime;		// Use 'm_time', not the fields
+    FILETIME		m_time;			// New timestamp (UTC)
+    bool		m_clamp;		// Clamp newer timestamps
+    FILETIME		m_clampTime;		// Clamp timestamp (UTC)
+    unsigned long	m_shardIdx;		// Shard index of this run
+    unsigned long	m_shardCnt;		// Number of shards, or 0
+    unsigned		m_filters;		// Active filters, 'FI_XXX' bits
+    FILETIME		m_olderTime;		// Older-than timestamp (UTC)
+    FILETIME		m_newerTime;		// Newer-than timestamp (UTC)
+    ULONGLONG		m_minSize;		// Minimum file size
+    ULONGLONG		m_maxSize;		// Maximum file size
+    bool		m_typeDir;		// Select directories, not files
+    int			m_excludeCnt;		// Number of excluded patterns
+    const char *	m_exclude[EXCLUDE_MAX];	// Excluded filename patterns
+
+public: // Static functions
+    static bool		parseDate(const char *date, SYSTEMTIME *st);
+						// Parse a date specification
+    static bool		parseTime(const char *spec, bool localTime,
+			    FILETIME *ft);	// Parse a timestamp specification
+    static void		toFileTime(ULONGLONG secs, DWORD ticks,
+			    FILETIME *ft);	// Convert a time since 1970
+    static void		fromFileTime(const FILETIME *ft, ULONGLONG *secs,
+			    DWORD *ticks);	// Convert a time to since 1970
+    static unsigned long hashPath(const char *fname);
+						// Hash a filename path
+    static int		splitPath(const char *pat, char *dir, int max);
+						// Get the directory of a filename
+    static int		daysInMonth(int year, int mon);
+						// Number of days in a month
+    static bool		parseSize(const char *spec, ULONGLONG *size);
+						// Parse a file size
+    static bool		matchName(const char *pat, const char *name);
+						// Match a wildcarded filename
+    static bool		formatTime(const FILETIME *ft, bool localTime,
+			    char *buf);		// Format a timestamp
+
+private: // Static functions
+    static bool		parseDigits(const char **s, int min, int max,
+			    int *v);		// Parse a date/time field
+
+public: // Functions
+    /*void*/		~ChtimePlan();		// Destructor
+    /*void*/		ChtimePlan();		// Default constructor
+
+    int			setModel(const char *fname, const char **msg);
+						// Use a model file's timestamp
+    void		setClamp(const FILETIME *ft);
+						// Clamp to a timestamp
+    bool		inShard(const char *fname) const;
+						// Filename belongs to this shard
+    bool		isClamped(const FILETIME *mtime) const;
+						// Timestamp needs no clamping
+    bool		isValidDate() const;	// Changed date fields are valid
+    void		setOlder(const FILETIME *ft);
+						// Select files older than a time
+    void		setNewer(const FILETIME *ft);
+						// Select files newer than a time
+    void		setSize(ULONGLONG min, ULONGLONG max);
+						// Select files within a size range
+    void		setType(bool dir);	// Select files or directories
+    bool		addExclude(const char *pat);
+						// Reject files matching a pattern
+    bool		isSelected(const WIN32_FIND_DATA *fs) const;
+						// File is selected by the filters
+    int			newTime(FILETIME *mtime, const char **msg) const;
+						// Determine a new timestamp
+};
+
+
+//------------------------------------------------------------------------------
+// struct ChtimeResult
+//	The outcome of changing the timestamp of a single file.
+//------------------------------------------------------------------------------
+
+struct ChtimeResult
+{
+    const char *	fname;		// Filename
+    int			rc;		// Status, 'ChtimePlan::RC_XXX'
+    const char *	msg;		// Failure message, or null
+    bool		skipped;	// File is not selected by the plan
+    bool		changed;	// Timestamp was modified
+    FILETIME		mtime;		// New timestamp (UTC)
+};
+
+
+//------------------------------------------------------------------------------
+// class ChtimeReporter
+//	Receives the outcomes of the files changed by a 'ChtimeExecutor' for a
+//	wildcarded filename, in the order in which the files were found.
+//------------------------------------------------------------------------------
+
+#define ChtimeReporter_VS 100			// Class version, 1.0
+
+class ChtimeReporter
+{
+public: // Functions
+    virtual /*void*/	~ChtimeReporter();	// Destructor
+
+    virtual int		report(const ChtimeResult *res) = 0;
+						// Receive the outcome for a file
+    virtual void	progress(const char *fname, long match);
+						// Receive the search progress
+};
+
+
+//------------------------------------------------------------------------------
+// class ChtimeDirCache
+//	Caches open handles to recently used directories, so that files can be
+//	opened relative to their directories without the file system resolving
+//	every component of their full paths again.
+//
+//	The least recently used directory handle is closed when the cache is
+//	full.  A cache is not thread-safe, and is meant to be owned by a single
+//	thread.
+//------------------------------------------------------------------------------
+
+#define ChtimeDirCache_VS 110			// Class version, 1.1
+
+class ChtimeDirCache
+{
+public: // Shared constants
+    enum Limits					// Implementation limits
+    {
+        DIR_CACHE_SIZE =	64,	// Default number of directories
+        DIR_CACHE_MAX =		1024	// Max number of directories
+    };
+
+private: // Shared constants
+    struct Entry				// Cached directory
+    {
+        HANDLE		dir;		// Directory handle, or null
+        unsigned long	hash;		// Hash of 'path'
+        DWORD		used;		// Time of last use
+        char		path[MAX_PATH+1]; // Directory path prefix
+    };
+
+private: // Variables
+    Entry *		m_ents;			// Cached directories
+    int			m_size;			// Size of 'm_ents'
+    DWORD		m_clock;		// Use counter
+
+public: // Functions
+    /*void*/		~ChtimeDirCache();	// Destructor
+    /*void*/		ChtimeDirCache(int size);
+						// Constructor
+
+    HANDLE		openFile(const char *fname);
+						// Open a file by its directory
+    int			getSize() const;	// Get the cache size
+    void		clear();		// Close all cached directories
+
+private: // Functions
+    HANDLE		openDir(const char *path);
+						// Get a cached directory handle
+
+    // Constructors and destructors not provided
+    /*void*/		ChtimeDirCache(const ChtimeDirCache &o);
+						// Copy constructor
+    const ChtimeDirCache &
+			operator =(const ChtimeDirCache &o);
+						// Assignment operator
+};
+
+
+//------------------------------------------------------------------------------
+// class ChtimeDirTimes
+//	Records the timestamps of the directories in which files are about to be
+//	created, and restores them afterwards.
+//
+//	Each directory is recorded only once, before the first file is created
+//	within it, so the cost is per directory rather than per file.  Only the
+//	directories in which a file was actually created are restored, and they
+//	may be restored any number of times.  All of the functions may be called
+//	by any thread.
+//------------------------------------------------------------------------------
+
+#define ChtimeDirTimes_VS 110			// Class version, 1.1
+
+class ChtimeDirTimes
+{
+private: // Shared constants
+    enum Limits					// Implementation limits
+    {
+        TIMES_INIT =	256	// Initial table size, a power of 2
+    };
+
+    struct Entry				// Recorded directory
+    {
+        char *		path;		// Full directory path, or null
+        unsigned long	hash;		// Hash of 'path'
+        bool		valid;		// Timestamps were retrieved
+        bool		created;	// A file was created within it
+        FILETIME	atime;		// Last access timestamp (UTC)
+        FILETIME	mtime;		// Modification timestamp (UTC)
+    };
+
+private: // Variables
+    Entry *		m_ents;			// Hash table of directories
+    int			m_size;			// Size of 'm_ents'
+    int			m_cnt;			// Number of directories
+    CRITICAL_SECTION	m_lock;			// Guards the table
+
+private: // Static functions
+    static bool		dirPath(const char *fname, char *path);
+						// Get the directory of a file
+
+public: // Functions
+    /*void*/		~ChtimeDirTimes();	// Destructor
+    /*void*/		ChtimeDirTimes();	// Default constructor
+
+    void		record(const char *fname);
+						// Record a file's directory
+    void		created(const char *fname);
+						// Mark a file as created
+    int			restore(const char **dname);
+						// Restore the directory times
+
+private: // Functions
+    Entry *		lookup(const char *path, unsigned long hash);
+						// Locate a directory entry
+    void		grow();			// Enlarge the hash table
+
+    // Constructors and destructors not provided
+    /*void*/		ChtimeDirTimes(const ChtimeDirTimes &o);
+						// Copy constructor
+    const ChtimeDirTimes &
+			operator =(const ChtimeDirTimes &o);
+						// Assignment operator
+};
+
+
+//------------------------------------------------------------------------------
+// class ChtimeExecutor
+//	Changes the modification timestamps of files according to a plan.
+//
+//	The files matching a wildcarded filename are searched for, selected by
+//	the plan, and changed (or listed, or have their archive members changed,
+//	according to the mode of the executor), with the outcome for each file
+//	passed to a reporter.
+//
+//	If a queue depth is set, each batch of files is queued on an I/O
+//	completion port and changed by a pool of worker threads, each with its
+//	own directory handle cache.  A batch is changed by only one caller
+//	thread at a time.
+//------------------------------------------------------------------------------
+
+#define ChtimeExecutor_VS 190			// Class version, 1.9
+
+class ChtimeExecutor
+{
+public: // Shared constants
+    enum Modes					// Operating modes
+    {
+        MO_CHANGE,		// Change the file timestamps
+        MO_LIST,		// Report the file timestamps only
+        MO_TAR			// Change the tar archive member times
+    };
+
+    enum Limits					// Implementation limits
+    {
+        QUEUE_DEPTH =	4,		// Default worker threads
+        QUEUE_MAX =	MAXIMUM_WAIT_OBJECTS,	// Max worker threads
+        QUEUE_BATCH =	256,		// Max batched found filenames
+        TAR_BLOCK =	512,		// Archive header block size
+        TAR_GRAIN =	64*1024,	// Archive mapping alignment
+        TAR_WINDOW =	64*1024*1024	// Archive mapping window size
+    };
+
+private: // Shared constants
+    struct TarMap				// Mapped archive file
+    {
+        HANDLE		map;		// File mapping
+        BYTE *		view;		// Mapped view of the file
+        ULONGLONG	viewOff;	// File offset of the view
+        ULONGLONG	viewLen;	// Length of the view
+        ULONGLONG	size;		// File size
+    };
+
+private: // Variables
+    const ChtimePlan &	m_plan;			// Plan to apply
+    int			m_mode;			// Operating mode, 'MO_XXX'
+    ChtimeDirCache *	m_cache;		// Directory handle cache, or null
+    ChtimeDirTimes *	m_times;		// Directory times to keep, or null
+    int			m_depth;		// Number of worker threads
+    HANDLE *		m_threads;		// Worker threads
+    HANDLE		m_port;			// Work queue, or null
+    HANDLE		m_done;			// Batch completion event
+    volatile LONG	m_pending;		// Files remaining in the batch
+    const char *const *	m_batchNames;		// Filenames of the batch
+    const bool *	m_batchDirs;		// Directory flags, or null
+    ChtimeResult *	m_batchRes;		// Results of the batch
+    char *		m_found;		// Batched found filenames, or null
+    const char **	m_foundPtrs;		// Pointers to batched filenames
+    bool *		m_foundDirs;		// Batched directory flags
+    ChtimeResult *	m_foundRes;		// Results of batched filenames
+    int			m_foundCnt;		// Number of batched filenames
+    char *		m_doneName;		// Last completed match
+    long		m_doneMatch;		// Completed matches, or 0
+
+private: // Static functions
+    static DWORD WINAPI	workerThread(LPVOID arg);
+						// Worker thread entry point
+    static bool		getTarNumber(const BYTE *f, int len,
+			    ULONGLONG *v);	// Get an archive header number
+    static void		putTarNumber(BYTE *f, int len, ULONGLONG v);
+						// Put an archive header number
+    static bool		putPaxTime(BYTE *f, int len, ULONGLONG secs,
+			    DWORD ticks);	// Put an extended header time
+    static BYTE *	mapArchive(TarMap *m, ULONGLONG off, DWORD len);
+						// Map part of an archive
+
+public: // Functions
+    /*void*/		~ChtimeExecutor();	// Destructor
+    /*void*/		ChtimeExecutor(const ChtimePlan &plan);
+						// Constructor
+
+    int			changeFile(const char *fname, ChtimeResult *res);
+						// Change time of a filename
+    int			createFile(const char *fname, ChtimeResult *res);
+						// Create a new file
+    int			changeFiles(const char *const *fnames, int n,
+			    ChtimeResult *res);	// Change times of some files
+    int			changePattern(const char *pat, ChtimeReporter *rep,
+			    long skip, const char *skipName);
+						// Change times of matching files
+    int			changeArchive(const char *fname, ChtimeReporter *rep);
+						// Change times of archive members
+    void		setMode(int mode);	// Set the operating mode
+    void		setDirCache(ChtimeDirCache *cache);
+						// Open files by their directories
+    void		setDirTimes(ChtimeDirTimes *times);
+						// Keep the times of directories
+    bool		setQueueDepth(int n);	// Change files on worker threads
+
+private: // Functions
+    int			changeEntry(const char *fname, bool dir,
+			    ChtimeDirCache *cache, ChtimeResult *res);
+						// Change time of a file or dir
+    int			changeOne(const char *fname, bool dir,
+			    ChtimeDirCache *cache, ChtimeResult *res);
+						// Change a file of a batch
+    int			runBatch(const char *const *fnames,
+			    const bool *dirs, int n, ChtimeResult *res);
+						// Change times of a batch
+    int			addFound(const char *fname, bool dir,
+			    ChtimeReporter *rep);
+						// Batch a found filename
+    int			flushFound(ChtimeReporter *rep);
+						// Change batched found filenames
+    void		advance(const char *fname, long match,
+			    ChtimeReporter *rep);
+						// Report the search progress
+    void		runWorker();		// Change queued files
+    void		stopWorkers();		// Terminate the worker threads
+
+    // Constructors and destructors not provided
+    /*void*/		ChtimeExecutor(const ChtimeExecutor &o);
+						// Copy constructor
+    const ChtimeExecutor &
+			operator =(const ChtimeExecutor &o);
+						// Assignment operator
+};
+
+#endif // libchtime_h
+
+// End libchtime.h